@@ -21,7 +21,16 @@ public:
     std::string server_host;
     unsigned short server_port;
     std::string doc_root;
+    std::string data_root;
+    std::string snapshot_root;
+    bool snapshot_verify;
+    bool watch_data;
     unsigned short threads;
+    std::string io_mode;
+    bool pin_threads;
+    unsigned short compute_threads;
+    std::size_t indicator_cache_mb;
+    std::size_t symbol_cache_mb;
 
     // Application Configuration
     std::string log_level;
@@ -50,7 +59,16 @@ public:
     void set_server_host(const std::string& host) { server_host = host; }
     void set_server_port(unsigned short port) { server_port = port; }
     void set_doc_root(const std::string& root) { doc_root = root; }
+    void set_data_root(const std::string& root) { data_root = root; }
+    void set_snapshot_root(const std::string& root) { snapshot_root = root; }
+    void set_snapshot_verify(bool verify) { snapshot_verify = verify; }
+    void set_watch_data(bool watch) { watch_data = watch; }
     void set_threads(unsigned short num_threads) { threads = num_threads; }
+    void set_io_mode(const std::string& mode) { io_mode = mode; }
+    void set_pin_threads(bool pin) { pin_threads = pin; }
+    void set_compute_threads(unsigned short num_threads) { compute_threads = num_threads; }
+    void set_indicator_cache_mb(std::size_t mb) { indicator_cache_mb = mb; }
+    void set_symbol_cache_mb(std::size_t mb) { symbol_cache_mb = mb; }
 
     void set_log_level(const std::string& level) { log_level = level; }
     void set_api_key(const std::string& key) { api_key = key; }
@@ -103,6 +121,14 @@ private:
         }
 
         doc_root = get_env("DOC_ROOT", false, "/var/www/");
+        data_root = get_env("DATA_ROOT", false, "../data/");
+        // Binary snapshots written by cap_snapshot; empty looks next to the CSVs
+        snapshot_root = get_env("SNAPSHOT_ROOT", false, "");
+        std::string snapshot_verify_str = get_env("SNAPSHOT_VERIFY", false, "false");
+        snapshot_verify = (snapshot_verify_str == "true" || snapshot_verify_str == "1");
+        // Pick up rows appended to the CSVs without a restart
+        std::string watch_data_str = get_env("WATCH_DATA", false, "true");
+        watch_data = (watch_data_str == "true" || watch_data_str == "1");
         std::string threads_str = get_env("THREADS", false, "1");
         try {
             threads = static_cast<unsigned short>(std::stoi(threads_str));
@@ -111,6 +137,46 @@ private:
             threads = 1;
         }
 
+        // "shared": every io thread runs one io_context. "per_core": one
+        // io_context and SO_REUSEPORT listener per thread, one per CPU unless
+        // --threads says otherwise.
+        io_mode = get_env("IO_MODE", false, "shared");
+        if (io_mode != "shared" && io_mode != "per_core") {
+            spdlog::warn("Unknown IO_MODE '{}', defaulting to 'shared'.", io_mode);
+            io_mode = "shared";
+        }
+        // Pins per_core io threads to their CPUs
+        std::string pin_threads_str = get_env("PIN_THREADS", false, "true");
+        pin_threads = (pin_threads_str == "true" || pin_threads_str == "1");
+
+        // 0 sizes the compute pool to the number of hardware threads
+        std::string compute_threads_str = get_env("COMPUTE_THREADS", false, "0");
+        try {
+            compute_threads = static_cast<unsigned short>(std::stoi(compute_threads_str));
+        } catch (const std::invalid_argument& e) {
+            spdlog::warn("Invalid COMPUTE_THREADS value: {}. Defaulting to 0.", compute_threads_str);
+            compute_threads = 0;
+        }
+
+        // Memory for cached technical indicators; 0 computes them per request
+        std::string indicator_cache_str = get_env("INDICATOR_CACHE_MB", false, "64");
+        try {
+            indicator_cache_mb = static_cast<std::size_t>(std::stoul(indicator_cache_str));
+        } catch (const std::invalid_argument& e) {
+            spdlog::warn("Invalid INDICATOR_CACHE_MB value: {}. Defaulting to 64.", indicator_cache_str);
+            indicator_cache_mb = 64;
+        }
+
+        // Memory for resident price series; beyond it the least recently
+        // used symbols are evicted and reloaded on demand. 0 keeps them all.
+        std::string symbol_cache_str = get_env("SYMBOL_CACHE_MB", false, "0");
+        try {
+            symbol_cache_mb = static_cast<std::size_t>(std::stoul(symbol_cache_str));
+        } catch (const std::invalid_argument& e) {
+            spdlog::warn("Invalid SYMBOL_CACHE_MB value: {}. Defaulting to 0.", symbol_cache_str);
+            symbol_cache_mb = 0;
+        }
+
         // Application Configuration
         log_level = get_env("LOG_LEVEL", false, "info");
         api_key = get_env("API_KEY", false, "");
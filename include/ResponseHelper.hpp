@@ -3,14 +3,14 @@
 
 #include "StandardResponse.hpp"
 
-// Create a successful response with data
-inline StandardResponse create_success_response(int code, const json& data, const json& meta = json::object()) {
+// Create a successful response with data (moved in when passed an rvalue)
+inline StandardResponse create_success_response(int code, json data, json meta = json::object()) {
     StandardResponse res;
     res.Ok = true;
     res.Code = code;
-    res.Data = data;
+    res.Data = std::move(data);
     if (!meta.empty()) {
-        res.Meta = meta;
+        res.Meta = std::move(meta);
     }
     return res;
 }
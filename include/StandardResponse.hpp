@@ -5,6 +5,7 @@
 #include <nlohmann/json.hpp>
 #include <string>
 #include <optional>
+#include "envelope_writer.hpp"
 
 using json = nlohmann::json;
 
@@ -41,6 +42,28 @@ struct StandardResponse {
 
         return j;
     }
+
+    // Appends the same document as to_json().dump() to out, without building
+    // an intermediate json object or string
+    void write_json(std::string& out) const {
+        envelope_writer env(out);
+        if (Data.has_value()) {
+            env.data().value(Data.value());
+        }
+        if (Error.has_value()) {
+            env.error(Error.value());
+        }
+        if (Errors.has_value()) {
+            env.errors(Errors.value());
+        }
+        if (Message.has_value()) {
+            env.message(Message.value());
+        }
+        if (Meta.has_value()) {
+            env.meta().value(Meta.value());
+        }
+        env.finish(Ok, Code);
+    }
 };
 
 #endif // STANDARD_RESPONSE_HPP
\ No newline at end of file
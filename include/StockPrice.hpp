@@ -6,7 +6,11 @@
 #include <stdexcept>
 #include <iostream> // For logging
 #include <algorithm> // For std::find_if
+#include <string_view>
+#include <nlohmann/json.hpp>
 #include "spdlog/spdlog.h"
+#include "csv_parser.hpp"
+#include "csv_schema.hpp"
 
 // Define StockPrice struct
 struct StockPrice {
@@ -43,36 +47,10 @@ inline void to_json(nlohmann::json& j, const StockPrice& stock) {
 inline StockPrice map_to_stock_price(const std::map<std::string, std::string>& row) {
     StockPrice stock;
 
-
-    // Log the available keys in the current row for debugging
-    spdlog::info("Keys in the current row:");
-    for (const auto& [key, value] : row) {
-        spdlog::info("  Key: '{}', Length: {}", key, key.size());
-        for (size_t i = 0; i < key.size(); ++i) {
-            spdlog::info("    Char {}: '{}' (ASCII: {})", i, key[i], static_cast<int>(key[i]));
-        }
-    }
-
     // Helper function to retrieve a value, strip quotes, or throw a meaningful error
     auto get_value = [&row](const std::string& key) -> std::string {
-        auto stripped_key = strip_quotes(key);
-
-        // Log the stripped and original keys for verification
-        spdlog::info("Searching for key: '{}', after stripping: '{}', Length: {}", key, key, key.size());
-        for (size_t i = 0; i < stripped_key.size(); ++i) {
-            spdlog::info("    Char {}: '{}' (ASCII: {})", i, key[i], static_cast<int>(key[i]));
-        }
-
-        auto it = row.find(stripped_key);
+        auto it = row.find(key);
         if (it == row.end()) {
-            // Log all keys present in the row for detailed comparison
-            spdlog::error("Could not find stripped key '{}'. Available keys are:", stripped_key);
-            for (const auto& [available_key, _] : row) {
-                spdlog::error("  Available Key: '{}', Length: {}", available_key, available_key.size());
-                for (size_t i = 0; i < available_key.size(); ++i) {
-                    spdlog::info("    Char {}: '{}' (ASCII: {})", i, available_key[i], static_cast<int>(available_key[i]));
-                }
-            }
             throw std::runtime_error("Missing key in row: " + key);
         }
         return strip_quotes(it->second); // Strip quotes from the value
@@ -94,4 +72,41 @@ inline StockPrice map_to_stock_price(const std::map<std::string, std::string>& r
     return stock;
 }
 
+// Column layout of the exported price files. load_csv_typed<StockPrice>
+// resolves these once per file instead of looking keys up on every row.
+template <>
+struct csv_schema<StockPrice> {
+    static constexpr auto columns = std::make_tuple(
+        csv_bind("Date", &StockPrice::Date),
+        csv_bind("Price", &StockPrice::Price),
+        csv_bind("Open", &StockPrice::Open),
+        csv_bind("High", &StockPrice::High),
+        csv_bind("Low", &StockPrice::Low),
+        csv_bind("Vol.", &StockPrice::Volume),
+        csv_bind<csv_percent>("Change %", &StockPrice::ChangePercent));
+};
+
+// Maps a record from csv_reader to StockPrice. Fields are read straight from
+// the mapped file, so the only allocations are the Date/Volume strings, which
+// fit in the small-string buffer for the exported price files.
+inline StockPrice map_csv_row_to_stock_price(const csv_row& row) {
+    StockPrice stock;
+    try {
+        std::string_view change = row.field("Change %");
+        if (!change.empty() && change.back() == '%') {
+            change.remove_suffix(1);
+        }
+        stock.Date.assign(row.field("Date"));
+        stock.Price = csv_to_double(row.field("Price"));
+        stock.Open = csv_to_double(row.field("Open"));
+        stock.High = csv_to_double(row.field("High"));
+        stock.Low = csv_to_double(row.field("Low"));
+        stock.Volume.assign(row.field("Vol."));
+        stock.ChangePercent = csv_to_double(change);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Error in mapping row to StockPrice: " + std::string(e.what()));
+    }
+    return stock;
+}
+
 #endif // STOCK_PRICE_HPP
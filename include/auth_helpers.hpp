@@ -14,7 +14,8 @@ namespace http = boost::beast::http;
 using json = nlohmann::json;
 
 // Extract Bearer token from the Authorization header
-inline std::optional<std::string> extract_bearer_token(const http::request<http::string_body>& req) {
+template <class Body, class Allocator>
+std::optional<std::string> extract_bearer_token(const http::request<Body, http::basic_fields<Allocator>>& req) {
     auto auth_iter = req.find(http::field::authorization);
     if (auth_iter != req.end()) {
         std::string auth_header = auth_iter->value().to_string();
@@ -44,74 +45,57 @@ inline bool verify_jwt(const std::string& token, const std::string& secret, cons
     }
 }
 
-// Check if a request is to a protected route and perform JWT authentication
-template <class Send>
-bool check_protected_route(
-    const http::request<http::string_body> &req,
+// Authenticate a request with its Bearer token. On failure a 401 or 403
+// response is sent and false returned.
+template <class Body, class Allocator, class Send>
+bool require_jwt(
+    const http::request<Body, http::basic_fields<Allocator>> &req,
     Send &&send,
-    const std::vector<std::string> &protected_routes,
     const Config &config)
 {
-    // Check if the requested route is protected
-    bool is_protected = false;
-    for (const auto &route : protected_routes)
+    // Extract the Bearer token from the Authorization header
+    auto token_opt = extract_bearer_token(req);
+    if (!token_opt.has_value())
     {
-        if (req.target().starts_with(route))
-        {
-            is_protected = true;
-            break;
-        }
-    }
-
-    if (is_protected)
-    {
-        // Extract the Bearer token from the Authorization header
-        auto token_opt = extract_bearer_token(req);
-        if (!token_opt.has_value())
-        {
-            spdlog::warn("Missing or malformed Authorization header.");
-            // Respond with 401 Unauthorized
-            StandardResponse res_struct = create_error_response(401, "Missing or malformed Authorization header.", "Unauthorized");
-            json res_json = res_struct.to_json();
-            std::string response_body = res_json.dump();
-
-            http::response<http::string_body> res{
-                http::status::unauthorized, req.version()};
-            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            res.set(http::field::content_type, "application/json");
-            res.keep_alive(req.keep_alive());
-            res.body() = response_body;
-            res.prepare_payload();
-            send(std::move(res));
-            return false;
-        }
+        spdlog::warn("Missing or malformed Authorization header.");
+        // Respond with 401 Unauthorized
+        StandardResponse res_struct = create_error_response(401, "Missing or malformed Authorization header.", "Unauthorized");
 
-        std::string token = token_opt.value();
+        http::response<http::string_body> res{
+            http::status::unauthorized, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+        res_struct.write_json(res.body());
+        res.prepare_payload();
+        send(std::move(res));
+        return false;
+    }
 
-        // Verify the JWT token
-        bool is_valid = verify_jwt(token, config.jwt_secret, config.jwt_issuer);
-        if (!is_valid)
-        {
-            spdlog::warn("Invalid or expired JWT token.");
-            // Respond with 403 Forbidden
-            StandardResponse res_struct = create_error_response(403, "Invalid or expired token.", "Forbidden");
-            json res_json = res_struct.to_json();
-            std::string response_body = res_json.dump();
+    std::string token = token_opt.value();
 
-            http::response<http::string_body> res{
-                http::status::forbidden, req.version()};
-            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            res.set(http::field::content_type, "application/json");
-            res.keep_alive(req.keep_alive());
-            res.body() = response_body;
-            res.prepare_payload();
-            send(std::move(res));
-            return false;
-        }
+    // Verify the JWT token
+    bool is_valid = verify_jwt(token, config.jwt_secret, config.jwt_issuer);
+    if (!is_valid)
+    {
+        spdlog::warn("Invalid or expired JWT token.");
+        // Respond with 403 Forbidden
+        StandardResponse res_struct = create_error_response(403, "Invalid or expired token.", "Forbidden");
 
-        spdlog::info("JWT verification successful for request to {}", req.target());
+        http::response<http::string_body> res{
+            http::status::forbidden, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+        res_struct.write_json(res.body());
+        res.prepare_payload();
+        send(std::move(res));
+        return false;
     }
-    return true; // Authorized or not a protected route
+
+    spdlog::info("JWT verification successful for request to {}",
+                 std::string_view(req.target().data(), req.target().size()));
+    return true;
 }
 
 #endif // AUTH_HELPERS_HPP
\ No newline at end of file
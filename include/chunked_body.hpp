@@ -0,0 +1,71 @@
+// chunked_body.hpp
+#ifndef CHUNKED_BODY_HPP
+#define CHUNKED_BODY_HPP
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/core/error.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+
+// A Body whose content is produced on demand, for responses too large to
+// materialize. The payload size is unknown up front, so HTTP/1.1 responses
+// go out with chunked transfer encoding.
+//
+// The serializer asks for the next chunk only after the previous one has been
+// written to the socket, so a slow reader throttles the generator and memory
+// per response stays at about one chunk.
+struct generator_body {
+    // Appends the next piece of the body to out; returns false once the body
+    // is complete. Pieces are small (a row or so) and are batched into chunks.
+    using generator = std::function<bool(std::string& out)>;
+
+    struct value_type {
+        generator next;
+        std::size_t chunk_size = 16 * 1024;
+    };
+
+    class writer {
+        value_type& body_;
+        std::string buffer_;
+        bool done_ = false;
+
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer(boost::beast::http::header<isRequest, Fields> const&, value_type& body)
+            : body_(body)
+        {
+        }
+
+        void init(boost::beast::error_code& ec) {
+            ec = {};
+            done_ = !body_.next;
+            buffer_.reserve(body_.chunk_size);
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(boost::beast::error_code& ec) {
+            ec = {};
+            if (done_) {
+                return boost::none;
+            }
+            buffer_.clear();
+            while (buffer_.size() < body_.chunk_size) {
+                if (!body_.next(buffer_)) {
+                    done_ = true;
+                    break;
+                }
+            }
+            if (buffer_.empty()) {
+                return boost::none;
+            }
+            return std::make_pair(const_buffers_type(buffer_.data(), buffer_.size()), !done_);
+        }
+    };
+};
+
+#endif // CHUNKED_BODY_HPP
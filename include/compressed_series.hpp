@@ -0,0 +1,97 @@
+// compressed_series.hpp
+#ifndef COMPRESSED_SERIES_HPP
+#define COMPRESSED_SERIES_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "price_series.hpp"
+#include "series_query.hpp"
+
+// Read-only, block-compressed copy of a price_series, for keeping many
+// symbols resident in a fraction of the 52 bytes per row of plain columns.
+// Rows are cut into blocks of block_rows; each column of a block is one run
+// of a shared bit stream, encoded as in Gorilla (Pelkonen et al., VLDB 2015):
+//
+//  - Date: delta-of-delta against the previous row. Consecutive trading
+//    days repeat their gaps (1, or 3 over a weekend), so most rows take a
+//    single zero bit and the rest 9.
+//  - Price, Open, High, Low, Vol., Change %: XOR against the previous value
+//    of the column. An equal value is one bit; otherwise only the bits
+//    between the leading and trailing zeros of the XOR are stored, reusing
+//    the previous window when they fit in it.
+//  - A column run whose values are all whole cents or missing (the CSVs'
+//    two-decimal prices, percentages and volumes, which binary fractions
+//    never hold exactly) stores cent deltas instead: one bit when unchanged,
+//    8 bits for a move within 32 cents, wider buckets beyond.
+//
+// The block directory holds each block's first day and the bit offset of
+// each of its columns, so a range scan decodes only the blocks, and only the
+// columns, it touches. Values round-trip bit for bit, NaN included.
+class compressed_series {
+public:
+    static constexpr std::size_t block_rows = 512;
+
+    explicit compressed_series(const price_series& series);
+
+    const std::string& symbol() const noexcept { return symbol_; }
+    std::size_t size() const noexcept { return rows_; }
+    bool empty() const noexcept { return rows_ == 0; }
+    std::size_t blocks() const noexcept { return directory_.size(); }
+
+    // Rows whose day lies in [from, to], as find_day_range() over the
+    // uncompressed series; decodes the days of at most two blocks
+    row_range find_day_range(std::optional<std::int32_t> from, std::optional<std::int32_t> to) const;
+
+    // Decodes rows [block * block_rows, ...) of a block into out, which must
+    // hold block_rows values; returns the number of rows in the block
+    std::size_t decode_days(std::size_t block, std::int32_t* out) const;
+    // column is one of the double fields (not field_date)
+    std::size_t decode_block(std::size_t block, series_field column, double* out) const;
+
+    // Calls fn(first_row, values, count) with the values of column for the
+    // rows of range, one decoded block at a time
+    template <class Fn>
+    void scan(series_field column, row_range range, Fn&& fn) const;
+
+    // The full uncompressed series
+    price_series decompress() const;
+
+    std::size_t memory_bytes() const noexcept;
+
+private:
+    static constexpr std::size_t column_count = 7; // Date, then the six doubles
+
+    struct block_entry {
+        std::int32_t first_day;
+        std::uint64_t offsets[column_count]; // bit offset of each column's run
+    };
+
+    static std::size_t slot_of(series_field column);
+
+    std::string symbol_;
+    std::size_t rows_ = 0;
+    std::vector<block_entry> directory_;
+    std::vector<std::uint64_t> bits_; // MSB-first bit stream of every block
+};
+
+template <class Fn>
+void compressed_series::scan(series_field column, row_range range, Fn&& fn) const {
+    range.end = std::min(range.end, rows_);
+    if (range.empty()) {
+        return;
+    }
+    double values[block_rows];
+    for (std::size_t b = range.begin / block_rows; b * block_rows < range.end; ++b) {
+        const std::size_t first = b * block_rows;
+        const std::size_t count = decode_block(b, column, values);
+        const std::size_t begin = std::max(range.begin, first) - first;
+        const std::size_t end = std::min(range.end, first + count) - first;
+        fn(first + begin, values + begin, end - begin);
+    }
+}
+
+#endif // COMPRESSED_SERIES_HPP
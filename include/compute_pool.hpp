@@ -0,0 +1,47 @@
+// compute_pool.hpp
+#ifndef COMPUTE_POOL_HPP
+#define COMPUTE_POOL_HPP
+
+#include <boost/asio/thread_pool.hpp>
+#include <cstddef>
+#include <functional>
+
+// Process-wide pool for CPU-bound work (parsing, analytics), kept apart from
+// the io_context threads that serve sockets.
+class compute_pool {
+public:
+    static compute_pool& getInstance();
+
+    // Sets the pool size used when the pool is first created; 0 means one
+    // thread per hardware thread. Has no effect once getInstance() was called.
+    static void set_thread_count(std::size_t threads);
+
+    compute_pool(const compute_pool&) = delete;
+    compute_pool& operator=(const compute_pool&) = delete;
+
+    std::size_t concurrency() const noexcept { return threads_; }
+
+    // Runs fn(0) .. fn(count - 1) on the pool and the calling thread, and
+    // returns once all have finished. The first exception thrown by a task is
+    // rethrown here. The caller runs whatever the pool has not started, so it
+    // completes even when every pool thread is busy or blocked. Calls made
+    // from inside a pool task run inline, so tasks may use parallel_for
+    // without deadlocking the pool.
+    void parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+    // Queues fn on the pool without waiting for it. Like a parallel_for task,
+    // fn runs nested parallel_for calls inline, so it never blocks a pool
+    // thread on work queued behind it. An exception thrown by fn is logged
+    // and dropped.
+    void post(std::function<void()> fn);
+
+    boost::asio::thread_pool& pool() noexcept { return pool_; }
+
+private:
+    explicit compute_pool(std::size_t threads);
+
+    std::size_t threads_;
+    boost::asio::thread_pool pool_;
+};
+
+#endif // COMPUTE_POOL_HPP
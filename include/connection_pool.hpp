@@ -0,0 +1,83 @@
+// connection_pool.hpp
+#ifndef CONNECTION_POOL_HPP
+#define CONNECTION_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "request_arena.hpp"
+
+// Occupancy and reuse counters of the connection pools, summed over threads
+struct connection_pool_stats {
+    struct size_class {
+        std::size_t bytes = 0;    // block size
+        std::size_t cached = 0;   // free blocks held
+        std::uint64_t reused = 0; // allocations served from the cache
+        std::uint64_t fresh = 0;  // allocations that went to the heap
+    };
+    std::vector<size_class> classes;
+    std::size_t arenas_cached = 0;
+    std::size_t arenas_cached_bytes = 0; // block capacity of the cached arenas
+    std::uint64_t arenas_reused = 0;
+    std::uint64_t arenas_fresh = 0;
+    std::size_t live_sessions = 0;
+    std::size_t threads = 0; // threads that have used a pool
+};
+
+// Per-thread caches of the memory a connection needs: fixed-size blocks for
+// the session object (with its shared_ptr control block) and its read
+// buffer, and whole request arenas. A connection that closes leaves its
+// memory to the next one accepted on the same thread, so connection churn
+// costs no allocator traffic once the caches are warm. Blocks freed on
+// another thread join that thread's cache. Each cache is bounded; beyond it
+// memory goes back to the heap.
+namespace connection_pool {
+
+// Smallest and largest pooled block; other sizes use the heap directly
+constexpr std::size_t min_block_bytes = 64;
+constexpr std::size_t max_block_bytes = 64 * 1024;
+// Free memory each size class of a thread may hold, arenas per thread and
+// the block capacity those arenas may hold together. Arenas grown by large
+// requests count their full block, so a few of them fill the byte budget.
+constexpr std::size_t max_cached_bytes_per_class = 1024 * 1024;
+constexpr std::size_t max_cached_arenas = 64;
+constexpr std::size_t max_cached_arena_bytes = 4 * 1024 * 1024;
+
+void* allocate(std::size_t bytes);
+void deallocate(void* p, std::size_t bytes) noexcept;
+
+// A rewound arena from this thread's cache, or a new one
+std::unique_ptr<request_arena> take_arena();
+// Rewinds arena and caches it, unless that would exceed the count or byte
+// budget; then it is freed
+void give_arena(std::unique_ptr<request_arena> arena) noexcept;
+
+// Sessions count themselves in and out
+void session_opened() noexcept;
+void session_closed() noexcept;
+
+connection_pool_stats stats();
+
+} // namespace connection_pool
+
+// Allocator over the connection pools, for std::allocate_shared of sessions
+// and for their buffers
+template <class T>
+struct pool_allocator {
+    using value_type = T;
+
+    pool_allocator() noexcept = default;
+    template <class U>
+    pool_allocator(const pool_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) { return static_cast<T*>(connection_pool::allocate(n * sizeof(T))); }
+    void deallocate(T* p, std::size_t n) noexcept { connection_pool::deallocate(p, n * sizeof(T)); }
+
+    template <class U>
+    bool operator==(const pool_allocator<U>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const pool_allocator<U>&) const noexcept { return false; }
+};
+
+#endif // CONNECTION_POOL_HPP
@@ -0,0 +1,15 @@
+// cpu_affinity.hpp
+#ifndef CPU_AFFINITY_HPP
+#define CPU_AFFINITY_HPP
+
+#include <vector>
+
+// CPUs this process may run on, in ascending order. Falls back to
+// 0 .. hardware_concurrency - 1 where the affinity mask is unavailable.
+std::vector<int> allowed_cpus();
+
+// Restricts the calling thread to cpu. Returns false when pinning is not
+// supported or the kernel refused it; the thread then keeps floating.
+bool pin_current_thread(int cpu);
+
+#endif // CPU_AFFINITY_HPP
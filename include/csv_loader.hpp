@@ -8,6 +8,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <functional>
+#include "spdlog/spdlog.h"
 
 // Generic CSV loader function template
 template <typename T>
@@ -0,0 +1,299 @@
+// csv_parser.hpp
+#ifndef CSV_PARSER_HPP
+#define CSV_PARSER_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include "compute_pool.hpp"
+#include "mapped_file.hpp"
+
+// Zero-copy CSV tokenizer. Fields are string_views into the source text, so
+// the text (usually a mapped_file) must outlive every row handed out.
+//
+// Quoted fields are returned without their surrounding quotes. Escaped quotes
+// inside a quoted field ("") are left as-is in the view; use csv_unescape()
+// when the literal text is needed.
+
+// Returns the text with a leading UTF-8 BOM removed
+inline std::string_view csv_skip_bom(std::string_view text) {
+    if (text.size() >= 3 &&
+        text[0] == char(0xEF) && text[1] == char(0xBB) && text[2] == char(0xBF)) {
+        text.remove_prefix(3);
+    }
+    return text;
+}
+
+// Collapses doubled quotes of a quoted field into single quotes
+inline std::string csv_unescape(std::string_view field) {
+    std::string out;
+    out.reserve(field.size());
+    for (std::size_t i = 0; i < field.size(); ++i) {
+        out.push_back(field[i]);
+        if (field[i] == '"' && i + 1 < field.size() && field[i + 1] == '"') {
+            ++i;
+        }
+    }
+    return out;
+}
+
+// Parses a decimal number without allocating
+inline double csv_to_double(std::string_view field) {
+    double value = 0.0;
+    const char* first = field.data();
+    const char* last = field.data() + field.size();
+    if (first != last && *first == '+') {
+        ++first;
+    }
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec != std::errc() || ptr != last) {
+        throw std::runtime_error("Invalid number: '" + std::string(field) + "'");
+    }
+    return value;
+}
+
+class csv_reader;
+
+// One record of a CSV file. The field storage is reused from row to row, so a
+// csv_row should be kept for the duration of a single mapper call only.
+class csv_row {
+public:
+    std::size_t size() const noexcept { return fields_.size(); }
+    std::string_view operator[](std::size_t index) const { return fields_[index]; }
+
+    // Looks a field up by its header name; throws if the column is missing
+    std::string_view field(std::string_view column) const {
+        for (std::size_t i = 0; i < header_->size(); ++i) {
+            if ((*header_)[i] == column) {
+                if (i >= fields_.size()) {
+                    break;
+                }
+                return fields_[i];
+            }
+        }
+        throw std::runtime_error("Missing column '" + std::string(column) +
+                                 "' on line " + std::to_string(line_));
+    }
+
+    const std::vector<std::string_view>& header() const noexcept { return *header_; }
+    std::size_t line() const noexcept { return line_; }
+
+private:
+    friend class csv_reader;
+
+    const std::vector<std::string_view>* header_ = nullptr;
+    std::vector<std::string_view> fields_;
+    std::size_t line_ = 0;
+};
+
+// Splits CSV text into rows. The first record is taken as the header.
+class csv_reader {
+public:
+    explicit csv_reader(std::string_view text)
+        : text_(csv_skip_bom(text)), pos_(0), line_(0)
+    {
+        if (!read_record(header_)) {
+            throw std::runtime_error("CSV input has no header row");
+        }
+    }
+
+    // Reader over a slice of records that follow an already-parsed header,
+    // used to parse a file in independent chunks
+    csv_reader(std::string_view records, std::vector<std::string_view> header)
+        : text_(records), pos_(0), line_(0), header_(std::move(header))
+    {
+    }
+
+    const std::vector<std::string_view>& header() const noexcept { return header_; }
+
+    // Text after the header record
+    std::string_view remaining() const noexcept { return text_.substr(pos_); }
+
+    // Reads the next non-empty record into row; returns false at end of input
+    bool next(csv_row& row) {
+        row.header_ = &header_;
+        while (read_record(row.fields_)) {
+            if (row.fields_.size() == 1 && row.fields_[0].empty()) {
+                continue; // blank line
+            }
+            row.line_ = line_;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    bool read_record(std::vector<std::string_view>& fields) {
+        fields.clear();
+        if (pos_ >= text_.size()) {
+            return false;
+        }
+        ++line_;
+
+        const char* const begin = text_.data();
+        const char* const end = begin + text_.size();
+        const char* p = begin + pos_;
+
+        for (;;) {
+            if (p < end && *p == '"') {
+                // Quoted field: runs to the next quote that is not doubled
+                const char* start = ++p;
+                for (;;) {
+                    p = std::find(p, end, '"');
+                    if (p == end) {
+                        throw std::runtime_error("Unterminated quoted field on line " + std::to_string(line_));
+                    }
+                    if (p + 1 < end && p[1] == '"') {
+                        p += 2;
+                        continue;
+                    }
+                    break;
+                }
+                fields.emplace_back(start, static_cast<std::size_t>(p - start));
+                ++p; // closing quote
+                // Tolerate stray characters between the closing quote and the delimiter
+                while (p < end && *p != ',' && *p != '\n') {
+                    ++p;
+                }
+            } else {
+                const char* start = p;
+                while (p < end && *p != ',' && *p != '\n') {
+                    ++p;
+                }
+                const char* stop = p;
+                if (stop > start && stop[-1] == '\r') {
+                    --stop;
+                }
+                fields.emplace_back(start, static_cast<std::size_t>(stop - start));
+            }
+
+            if (p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            if (p < end) {
+                ++p; // '\n'
+            }
+            break;
+        }
+
+        pos_ = static_cast<std::size_t>(p - begin);
+        return true;
+    }
+
+    std::string_view text_;
+    std::size_t pos_;
+    std::size_t line_;
+    std::vector<std::string_view> header_;
+};
+
+// Splits records into at most `parts` slices, each ending just after a
+// newline, of roughly equal size and at least min_bytes long
+inline std::vector<std::string_view> csv_split_chunks(std::string_view records, std::size_t parts,
+                                                      std::size_t min_bytes = 1 << 20) {
+    std::vector<std::string_view> chunks;
+    parts = std::max<std::size_t>(1, std::min(parts, records.size() / std::max<std::size_t>(min_bytes, 1)));
+    const std::size_t target = records.size() / parts;
+
+    std::size_t begin = 0;
+    while (begin < records.size()) {
+        std::size_t end = records.size();
+        if (chunks.size() + 1 < parts) {
+            std::size_t nl = records.find('\n', begin + target);
+            end = nl == std::string_view::npos ? records.size() : nl + 1;
+        }
+        chunks.push_back(records.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+namespace detail {
+
+// Maps every remaining record of reader
+template <typename T, typename RowMapper>
+std::vector<T> csv_map_rows(csv_reader& reader, RowMapper& row_mapper) {
+    std::string_view records = reader.remaining();
+    std::vector<T> data;
+    // Cheap upper bound on the row count keeps push_back from reallocating
+    data.reserve(static_cast<std::size_t>(std::count(records.begin(), records.end(), '\n')) + 1);
+
+    csv_row row;
+    while (reader.next(row)) {
+        data.push_back(row_mapper(row));
+    }
+    return data;
+}
+
+// Maps the records following head's header in newline-aligned chunks on the
+// compute pool. Returns nullopt if any chunk fails so the caller can retry
+// serially (see load_csv_parallel).
+template <typename T, typename RowMapper>
+std::optional<std::vector<T>> csv_map_chunks(const csv_reader& head, RowMapper& row_mapper, std::size_t parts) {
+    compute_pool& pool = compute_pool::getInstance();
+    std::vector<std::string_view> chunks =
+        csv_split_chunks(head.remaining(), parts ? parts : pool.concurrency());
+    if (chunks.size() < 2) {
+        return std::nullopt;
+    }
+
+    std::vector<std::vector<T>> results(chunks.size());
+    try {
+        pool.parallel_for(chunks.size(), [&](std::size_t i) {
+            csv_reader reader(chunks[i], head.header());
+            results[i] = csv_map_rows<T>(reader, row_mapper);
+        });
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+
+    std::size_t total = 0;
+    for (const auto& part : results) {
+        total += part.size();
+    }
+    std::vector<T> data;
+    data.reserve(total);
+    for (auto& part : results) {
+        std::move(part.begin(), part.end(), std::back_inserter(data));
+    }
+    return data;
+}
+
+} // namespace detail
+
+// Memory-maps a CSV file and maps every record straight to T without building
+// an intermediate map. RowMapper is any callable T(const csv_row&).
+template <typename T, typename RowMapper>
+std::vector<T> load_csv_mapped(const std::string& filepath, RowMapper&& row_mapper) {
+    mapped_file file(filepath);
+    csv_reader reader(file.view());
+    return detail::csv_map_rows<T>(reader, row_mapper);
+}
+
+// Parallel variant of load_csv_mapped for large files: the records are split
+// at newline boundaries, the chunks are parsed on the compute pool, and the
+// results are concatenated in file order.
+//
+// A newline inside a quoted field would put a chunk boundary mid-record. The
+// chunk before such a boundary then fails with an unterminated quote, and the
+// whole file is re-parsed serially, so the result is always identical to
+// load_csv_mapped. The mapper must be safe to call concurrently.
+template <typename T, typename RowMapper>
+std::vector<T> load_csv_parallel(const std::string& filepath, RowMapper&& row_mapper, std::size_t parts = 0) {
+    mapped_file file(filepath);
+    csv_reader reader(file.view());
+    if (auto data = detail::csv_map_chunks<T>(reader, row_mapper, parts)) {
+        return std::move(*data);
+    }
+    return detail::csv_map_rows<T>(reader, row_mapper);
+}
+
+#endif // CSV_PARSER_HPP
@@ -0,0 +1,166 @@
+// csv_schema.hpp
+#ifndef CSV_SCHEMA_HPP
+#define CSV_SCHEMA_HPP
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "csv_parser.hpp"
+
+// Compile-time description of how CSV columns map onto a record type.
+//
+// A record type opts in by specializing csv_schema with a constexpr tuple of
+// column bindings:
+//
+//   template <> struct csv_schema<Quote> {
+//       static constexpr auto columns = std::make_tuple(
+//           csv_bind("Date", &Quote::date),
+//           csv_bind<csv_percent>("Change %", &Quote::change));
+//   };
+//
+// csv_binder<Quote> then resolves the header names to column positions once
+// per file, and each row is parsed field by field straight into the members.
+
+template <class Record>
+struct csv_schema;
+
+// Default field parsers, selected by member type
+
+template <class T, class = void>
+struct csv_field_parser;
+
+template <>
+struct csv_field_parser<double> {
+    static void parse(std::string_view field, double& out) { out = csv_to_double(field); }
+};
+
+template <>
+struct csv_field_parser<std::string> {
+    static void parse(std::string_view field, std::string& out) { out.assign(field); }
+};
+
+template <class Int>
+struct csv_field_parser<Int, std::enable_if_t<std::is_integral_v<Int>>> {
+    static void parse(std::string_view field, Int& out) {
+        auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), out);
+        if (ec != std::errc() || ptr != field.data() + field.size()) {
+            throw std::runtime_error("Invalid integer: '" + std::string(field) + "'");
+        }
+    }
+};
+
+// "1.25%" -> 1.25
+struct csv_percent {
+    static void parse(std::string_view field, double& out) {
+        if (!field.empty() && field.back() == '%') {
+            field.remove_suffix(1);
+        }
+        out = csv_to_double(field);
+    }
+};
+
+template <class Record, class Member, class Parser>
+struct csv_column {
+    std::string_view name;
+    Member Record::*member;
+};
+
+template <class Record, class Member>
+constexpr csv_column<Record, Member, csv_field_parser<Member>> csv_bind(std::string_view name, Member Record::*member) {
+    return {name, member};
+}
+
+template <class Parser, class Record, class Member>
+constexpr csv_column<Record, Member, Parser> csv_bind(std::string_view name, Member Record::*member) {
+    return {name, member};
+}
+
+// Row mapper for a record type with a csv_schema. Construction resolves each
+// bound column to its position in the header (throwing if one is missing);
+// mapping a row is then a fixed sequence of indexed field parses with no
+// lookups or temporaries. A binder is immutable and safe to share between
+// threads.
+template <class Record>
+class csv_binder {
+    static constexpr auto& columns = csv_schema<Record>::columns;
+    static constexpr std::size_t column_count = std::tuple_size_v<std::decay_t<decltype(columns)>>;
+
+public:
+    explicit csv_binder(const std::vector<std::string_view>& header) {
+        resolve(header, std::make_index_sequence<column_count>{});
+    }
+
+    Record operator()(const csv_row& row) const {
+        if (row.size() <= max_index_) {
+            throw std::runtime_error("Line " + std::to_string(row.line()) + ": expected " +
+                                     std::to_string(max_index_ + 1) + " fields, found " +
+                                     std::to_string(row.size()));
+        }
+        Record record{};
+        try {
+            parse(row, record, std::make_index_sequence<column_count>{});
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Line " + std::to_string(row.line()) + ": " + e.what());
+        }
+        return record;
+    }
+
+private:
+    template <std::size_t... I>
+    void resolve(const std::vector<std::string_view>& header, std::index_sequence<I...>) {
+        ((index_[I] = find(header, std::get<I>(columns).name)), ...);
+        max_index_ = 0;
+        for (std::size_t i : index_) {
+            max_index_ = std::max(max_index_, i);
+        }
+    }
+
+    template <std::size_t... I>
+    void parse(const csv_row& row, Record& record, std::index_sequence<I...>) const {
+        (parse_column(row[index_[I]], record, std::get<I>(columns)), ...);
+    }
+
+    template <class Member, class Parser>
+    static void parse_column(std::string_view field, Record& record, const csv_column<Record, Member, Parser>& column) {
+        Parser::parse(field, record.*(column.member));
+    }
+
+    static std::size_t find(const std::vector<std::string_view>& header, std::string_view name) {
+        for (std::size_t i = 0; i < header.size(); ++i) {
+            if (header[i] == name) {
+                return i;
+            }
+        }
+        throw std::runtime_error("Missing column '" + std::string(name) + "'");
+    }
+
+    std::array<std::size_t, column_count> index_{};
+    std::size_t max_index_ = 0;
+};
+
+// Loads a CSV file into records described by csv_schema<Record>. With
+// parallel set, large files are parsed in chunks on the compute pool (see
+// load_csv_parallel for the guarantees).
+template <class Record>
+std::vector<Record> load_csv_typed(const std::string& filepath, bool parallel = false) {
+    mapped_file file(filepath);
+    csv_reader reader(file.view());
+    const csv_binder<Record> binder(reader.header());
+    if (parallel) {
+        if (auto data = detail::csv_map_chunks<Record>(reader, binder, 0)) {
+            return std::move(*data);
+        }
+    }
+    return detail::csv_map_rows<Record>(reader, binder);
+}
+
+#endif // CSV_SCHEMA_HPP
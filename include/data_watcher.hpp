@@ -0,0 +1,51 @@
+// data_watcher.hpp
+#ifndef DATA_WATCHER_HPP
+#define DATA_WATCHER_HPP
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/system/error_code.hpp>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "symbol_store.hpp"
+
+// Watches the data root with inotify and keeps symbol_store in step with the
+// CSV files. Events are read on the io_context; the parsing itself runs on
+// the compute pool, so request threads never wait for a reload.
+//
+//   modified       refresh, complete lines only (the writer may not be done)
+//   closed/write   refresh up to end of file
+//   moved/deleted  reload from scratch (or drop the symbol)
+//
+// Repeated events for a symbol whose refresh has not started yet are merged.
+// Files are expected to be appended to; rewrite one by renaming a new file
+// over it.
+class data_watcher : public std::enable_shared_from_this<data_watcher> {
+public:
+    data_watcher(boost::asio::io_context& ioc, symbol_store& store);
+
+    // Starts watching store.data_root(); throws std::system_error when the
+    // directory cannot be watched
+    void run();
+
+private:
+    // Strongest pending action for a symbol; a later one subsumes earlier ones
+    enum class change { appended_lines, appended, replaced };
+
+    void do_read();
+    void on_read(boost::system::error_code ec, std::size_t bytes);
+    void schedule(std::string symbol, change what);
+
+    symbol_store& store_;
+    std::string root_;
+    boost::asio::posix::stream_descriptor descriptor_;
+    alignas(8) char buffer_[16 * 1024];
+
+    std::mutex pending_mutex_;
+    std::unordered_map<std::string, change> pending_;
+};
+
+#endif // DATA_WATCHER_HPP
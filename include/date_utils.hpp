@@ -0,0 +1,120 @@
+// date_utils.hpp
+#ifndef DATE_UTILS_HPP
+#define DATE_UTILS_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Calendar dates are stored as day numbers: days since 1970-01-01 in the
+// proleptic Gregorian calendar. They sort like the dates they represent and
+// subtract to a day count.
+
+// Day number of a civil date (H. Hinnant's days_from_civil)
+constexpr std::int32_t days_from_civil(int y, unsigned m, unsigned d) noexcept {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int>(doe) - 719468;
+}
+
+struct civil_date {
+    int year;
+    unsigned month;
+    unsigned day;
+};
+
+// Inverse of days_from_civil
+constexpr civil_date civil_from_days(std::int32_t z) noexcept {
+    z += 719468;
+    const int era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int y = static_cast<int>(yoe) + era * 400;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    return {y + (m <= 2), m, d};
+}
+
+// Week of a day number; two days share it iff they fall in the same Monday
+// to Sunday week. Day 4 (1970-01-05) is a Monday.
+constexpr std::int32_t week_number(std::int32_t day) noexcept {
+    const std::int32_t shifted = day + 3;
+    return shifted >= 0 ? shifted / 7 : (shifted - 6) / 7;
+}
+
+// Months since January 1970 (negative before)
+constexpr std::int32_t month_number(std::int32_t day) noexcept {
+    const civil_date c = civil_from_days(day);
+    return (c.year - 1970) * 12 + static_cast<std::int32_t>(c.month) - 1;
+}
+
+namespace detail {
+inline bool parse_date_digits(std::string_view text, std::size_t pos, std::size_t count, unsigned& out) {
+    out = 0;
+    for (std::size_t i = pos; i < pos + count; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        out = out * 10 + static_cast<unsigned>(text[i] - '0');
+    }
+    return true;
+}
+
+inline bool valid_civil(unsigned y, unsigned m, unsigned d) {
+    if (m < 1 || m > 12 || d < 1) {
+        return false;
+    }
+    static constexpr unsigned month_days[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (d > month_days[m - 1]) {
+        return false;
+    }
+    bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    return !(m == 2 && d == 29 && !leap);
+}
+} // namespace detail
+
+// Parses "dd/mm/yyyy" (the format of the exported price files) or ISO
+// "yyyy-mm-dd" into a day number. Throws std::invalid_argument otherwise.
+inline std::int32_t parse_day(std::string_view text) {
+    unsigned y = 0, m = 0, d = 0;
+    bool ok = false;
+    if (text.size() == 10 && text[2] == '/' && text[5] == '/') {
+        ok = detail::parse_date_digits(text, 0, 2, d) &&
+             detail::parse_date_digits(text, 3, 2, m) &&
+             detail::parse_date_digits(text, 6, 4, y);
+    } else if (text.size() == 10 && text[4] == '-' && text[7] == '-') {
+        ok = detail::parse_date_digits(text, 0, 4, y) &&
+             detail::parse_date_digits(text, 5, 2, m) &&
+             detail::parse_date_digits(text, 8, 2, d);
+    }
+    if (!ok || !detail::valid_civil(y, m, d)) {
+        throw std::invalid_argument("Invalid date: '" + std::string(text) + "'");
+    }
+    return days_from_civil(static_cast<int>(y), m, d);
+}
+
+// Formats a day number as "dd/mm/yyyy"
+inline std::string format_day(std::int32_t day) {
+    civil_date c = civil_from_days(day);
+    std::string out(10, '0');
+    out[0] = static_cast<char>('0' + c.day / 10);
+    out[1] = static_cast<char>('0' + c.day % 10);
+    out[2] = '/';
+    out[3] = static_cast<char>('0' + c.month / 10);
+    out[4] = static_cast<char>('0' + c.month % 10);
+    out[5] = '/';
+    unsigned y = static_cast<unsigned>(c.year);
+    for (int i = 9; i >= 6; --i) {
+        out[static_cast<std::size_t>(i)] = static_cast<char>('0' + y % 10);
+        y /= 10;
+    }
+    return out;
+}
+
+#endif // DATE_UTILS_HPP
@@ -0,0 +1,57 @@
+// envelope_writer.hpp
+#ifndef ENVELOPE_WRITER_HPP
+#define ENVELOPE_WRITER_HPP
+
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+#include "json_writer.hpp"
+
+// Writes the StandardResponse envelope straight into an output buffer.
+// Members are optional but must be written in key order (data, error, errors,
+// message, meta) before finish(); that is the sorted order nlohmann uses, so
+// the bytes match StandardResponse::to_json().dump().
+class envelope_writer {
+public:
+    explicit envelope_writer(std::string& out) : writer_(out) {
+        writer_.begin_object();
+    }
+
+    // Starts the "data" member; write exactly one value to the returned writer
+    json_writer& data() {
+        writer_.key("data");
+        return writer_;
+    }
+
+    envelope_writer& error(std::string_view error) {
+        writer_.key("error").value(error);
+        return *this;
+    }
+
+    envelope_writer& errors(const nlohmann::json& errors) {
+        writer_.key("errors").value(errors);
+        return *this;
+    }
+
+    envelope_writer& message(std::string_view message) {
+        writer_.key("message").value(message);
+        return *this;
+    }
+
+    // Starts the "meta" member; write exactly one value to the returned writer
+    json_writer& meta() {
+        writer_.key("meta");
+        return writer_;
+    }
+
+    void finish(bool ok, int code) {
+        writer_.key("ok").value(ok);
+        writer_.key("status_code").value(code);
+        writer_.end_object();
+    }
+
+private:
+    json_writer writer_;
+};
+
+#endif // ENVELOPE_WRITER_HPP
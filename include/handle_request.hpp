@@ -6,7 +6,11 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 #include <nlohmann/json.hpp>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include "mime_types.hpp"
 #include "path_cat.hpp"
 #include "utility.hpp"
@@ -23,12 +27,65 @@
 #include "handler_loadcsv.hpp"
 #include "handler_db.hpp"
 #include "handler_login.hpp"
+#include "handler_stats.hpp"
+#include "handler_range.hpp"
+#include "handler_correlation.hpp"
+#include "handler_backtest.hpp"
+#include "handler_simulate.hpp"
+#include "handler_indicators.hpp"
+#include "handler_quantiles.hpp"
+#include "handler_symbols.hpp"
+#include "handler_coalescing.hpp"
+#include "handler_connections.hpp"
 #include "request_utils.hpp"
+#include "query_params.hpp"
+#include "request_arena.hpp"
+#include "router.hpp"
 
 using json = nlohmann::json;
 namespace beast = boost::beast;
 namespace http = beast::http;
 
+// Calls fn with each symbol the matched route reads from the symbol store:
+// its {symbol} parameter, or the names in ?symbols= or in ?weights=
+// (name:weight pairs)
+template <class Body, class Allocator, class Fn>
+void for_each_route_symbol(
+    const router::match &route,
+    const http::request<Body, http::basic_fields<Allocator>> &req,
+    Fn &&fn)
+{
+    const char *list_param = nullptr;
+    switch (route.id)
+    {
+    case route_id::loadcsv:
+    case route_id::stats:
+    case route_id::range:
+    case route_id::simulate:
+    case route_id::indicators:
+        return fn(route.param("symbol"));
+    case route_id::correlation:
+    case route_id::quantiles:
+        list_param = "symbols";
+        break;
+    case route_id::backtest:
+        list_param = "weights";
+        break;
+    default:
+        return;
+    }
+    query_params params(route.query, request_resource(req));
+    auto list = params.get(list_param);
+    std::string_view rest = list ? *list : std::string_view{};
+    while (!rest.empty())
+    {
+        auto comma = rest.find(',');
+        std::string_view item = rest.substr(0, comma);
+        rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+        fn(item.substr(0, item.find(':')));
+    }
+}
+
 // This function produces an HTTP response for the given request.
 // The type of the response object depends on the contents of the request,
 template <class Body, class Allocator, class Send>
@@ -38,55 +95,105 @@ void handle_request(
     Send &&send,
     std::shared_ptr<IDatabase> db)
 {
-    spdlog::info("Received {} request for {}", std::string(req.method_string()), std::string(req.target()));
+    spdlog::info("Received {} request for {}",
+                 std::string_view(req.method_string().data(), req.method_string().size()),
+                 std::string_view(req.target().data(), req.target().size()));
 
     Config &config = Config::getInstance();
 
-    // List of protected routes that require JWT authentication
-    std::vector<std::string> protected_routes = {"/api", "/db"};
+    const router::match route = api_router().find(
+        req.method(), std::string_view(req.target().data(), req.target().size()));
 
-    // Perform the authorization check
-    if (!check_protected_route(req, std::forward<Send>(send), protected_routes, config))
+    // Perform the authorization check required by the route, or by the
+    // protected prefix of a path no route matches
+    if (route.auth == auth_policy::jwt && !require_jwt(req, send, config))
     {
         return;
     }
 
-    if (req.target() == "/login" && req.method() == http::verb::post)
+    if (route.result == router::outcome::method_not_allowed)
     {
-        handle_login_route(std::forward<decltype(req)>(req), send, db);
-        return;
+        return send(method_not_allowed(req, allow_header(route.allow)));
     }
 
-    if (req.target() == "/hello")
+    if (route.result == router::outcome::matched)
     {
-        handle_hello_route(std::forward<decltype(req)>(req), send);
-        return;
-    }
-
-    if (req.target() == "/db")
-    {
-        handle_db_route(std::forward<decltype(req)>(req), send, db);
-        return;
-    }
-
-    if (req.target().starts_with("/loadcsv/"))
-    {
-        // Extract the file name after '/loadcsv/'
-        std::string target_str = std::string(req.target());
-        std::string file_name = target_str.substr(std::string("/loadcsv/").length());
-
-        // Validate the file name if necessary (e.g., check against a list of valid symbols or format)
-        if (file_name.empty())
+        // A request for a symbol that another request is loading is deferred
+        // (see response_queue::defer) and runs again once that load is done,
+        // rather than blocking this io thread on it
+        using request_type = std::decay_t<decltype(req)>;
+        std::shared_ptr<std::optional<request_type>> waiting;
+        for_each_route_symbol(route, req, [&](std::string_view symbol) {
+            symbol_store &store = symbol_store::getInstance();
+            if (waiting || store.peek(symbol))
+                return;
+            auto held = std::make_shared<std::optional<request_type>>();
+            auto rerun = [held, later = send.defer(), doc_root, db] {
+                later([held, doc_root, db](auto &send) {
+                    handle_request(doc_root, std::move(**held), send, db);
+                });
+            };
+            if (!store.load_or_wait(symbol, std::move(rerun)))
+                waiting = std::move(held);
+        });
+        if (waiting)
         {
-            http::response<http::string_body> res = bad_request(req, "Missing file name.");
-            return send(std::move(res));
+            // The rerun is posted to this session's executor, so it cannot
+            // start before this returns
+            waiting->emplace(std::move(req));
+            return;
         }
 
-        // Pass the file name to the route handler
-        handle_loadcsv_route(std::forward<decltype(req)>(req), send, db, file_name);
-        return;
+        switch (route.id)
+        {
+        case route_id::login:
+            return handle_login_route(std::forward<decltype(req)>(req), send, db);
+        case route_id::hello:
+            return handle_hello_route(std::forward<decltype(req)>(req), send);
+        case route_id::db:
+            return handle_db_route(std::forward<decltype(req)>(req), send, db);
+        case route_id::loadcsv:
+            return handle_loadcsv_route(std::forward<decltype(req)>(req), send,
+                                        std::string(route.param("symbol")),
+                                        query_params(route.query, request_resource(req)));
+        case route_id::connections:
+            return handle_connections_route(std::forward<decltype(req)>(req), send);
+        case route_id::coalescing:
+            return handle_coalescing_route(std::forward<decltype(req)>(req), send);
+        case route_id::symbols:
+            return handle_symbols_route(std::forward<decltype(req)>(req), send,
+                                        query_params(route.query, request_resource(req)));
+        case route_id::stats:
+            return handle_stats_route(std::forward<decltype(req)>(req), send,
+                                      std::string(route.param("symbol")),
+                                      query_params(route.query, request_resource(req)));
+        case route_id::range:
+            return handle_range_route(std::forward<decltype(req)>(req), send,
+                                      std::string(route.param("symbol")),
+                                      query_params(route.query, request_resource(req)));
+        case route_id::correlation:
+            return handle_correlation_route(std::forward<decltype(req)>(req), send,
+                                            query_params(route.query, request_resource(req)));
+        case route_id::quantiles:
+            return handle_quantiles_route(std::forward<decltype(req)>(req), send,
+                                          query_params(route.query, request_resource(req)));
+        case route_id::backtest:
+            return handle_backtest_route(std::forward<decltype(req)>(req), send,
+                                         query_params(route.query, request_resource(req)));
+        case route_id::backtest_batch:
+            return handle_backtest_batch_route(std::forward<decltype(req)>(req), send);
+        case route_id::simulate:
+            return handle_simulate_route(std::forward<decltype(req)>(req), send,
+                                         std::string(route.param("symbol")),
+                                         query_params(route.query, request_resource(req)));
+        case route_id::indicators:
+            return handle_indicators_route(std::forward<decltype(req)>(req), send,
+                                           std::string(route.param("symbol")),
+                                           query_params(route.query, request_resource(req)));
+        }
     }
 
+    // Anything else is a static file
     if (req.target().empty() ||
         req.target()[0] != '/' ||
         req.target().find("..") != beast::string_view::npos)
@@ -112,15 +219,13 @@ void handle_request(
         spdlog::warn("File not found: {}", path);
 
         StandardResponse res_struct = create_not_found_response(std::string(req.target()));
-        json res_json = res_struct.to_json();
-        std::string response_body = res_json.dump();
 
         http::response<http::string_body> res{
             http::status::not_found, req.version()};
         res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
         res.set(http::field::content_type, "application/json");
         res.keep_alive(req.keep_alive());
-        res.body() = response_body;
+        res_struct.write_json(res.body());
         res.prepare_payload();
         return send(std::move(res));
     }
@@ -131,15 +236,13 @@ void handle_request(
         spdlog::error("Error opening file {}: {}", path, ec.message());
 
         StandardResponse res_struct = create_server_error_response(ec.message());
-        json res_json = res_struct.to_json();
-        std::string response_body = res_json.dump();
 
         http::response<http::string_body> res{
             http::status::internal_server_error, req.version()};
         res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
         res.set(http::field::content_type, "application/json");
         res.keep_alive(req.keep_alive());
-        res.body() = response_body;
+        res_struct.write_json(res.body());
         res.prepare_payload();
         return send(std::move(res));
     }
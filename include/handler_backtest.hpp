@@ -0,0 +1,301 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "symbol_store.hpp"
+#include "portfolio_backtest.hpp"
+#include "query_params.hpp"
+#include "date_utils.hpp"
+#include "envelope_writer.hpp"
+
+using json = nlohmann::json;
+
+// Settings shared by the single and batch forms of /api/backtest
+struct backtest_request
+{
+    std::vector<std::string> symbols;
+    std::optional<std::int32_t> from;
+    std::optional<std::int32_t> to;
+    rebalance_period rebalance = rebalance_period::monthly;
+    double risk_free = 0.0; // annual rate for the Sharpe ratio
+};
+
+// Resolves the symbols of a backtest to resident series. Returns the first
+// unknown symbol in missing instead when there is one.
+inline std::vector<std::shared_ptr<const price_series>> backtest_series(
+    const std::vector<std::string> &symbols, std::string &missing)
+{
+    std::vector<std::shared_ptr<const price_series>> series;
+    series.reserve(symbols.size());
+    for (const auto &name : symbols)
+    {
+        auto s = symbol_store::getInstance().get(name);
+        if (!s)
+        {
+            missing = name;
+            return {};
+        }
+        series.push_back(std::move(s));
+    }
+    return series;
+}
+
+// GET /api/backtest?weights=spy_etf:0.6,meta_stock:0.4&from=&to=
+//     &rebalance=monthly&risk_free=0.02&capital=10000
+// One weighted basket: the equity curve (oldest first) and its summary.
+template <class Body, class Allocator, class Send>
+void handle_backtest_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send,
+    const query_params &params)
+{
+    spdlog::info("Handling /api/backtest route");
+
+    backtest_request settings;
+    std::vector<double> weights;
+    double capital = 1.0;
+    try
+    {
+        auto list = params.get("weights");
+        if (!list)
+            throw std::invalid_argument("Missing weights, e.g. ?weights=spy_etf:0.6,meta_stock:0.4");
+        std::string_view rest = *list;
+        while (!rest.empty())
+        {
+            auto comma = rest.find(',');
+            std::string_view item = rest.substr(0, comma);
+            rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+            auto colon = item.find(':');
+            std::string name(item.substr(0, colon));
+            if (!symbol_store::is_valid_symbol(name))
+                throw std::invalid_argument("Invalid symbol: '" + name + "'");
+            settings.symbols.push_back(std::move(name));
+            weights.push_back(colon == std::string_view::npos
+                                  ? 1.0
+                                  : parse_number_param("weight", item.substr(colon + 1)));
+        }
+        if (auto v = params.get("from"))
+            settings.from = parse_day(*v);
+        if (auto v = params.get("to"))
+            settings.to = parse_day(*v);
+        if (auto v = params.get("rebalance"))
+            settings.rebalance = parse_rebalance_period(*v);
+        if (auto v = params.get("risk_free"))
+            settings.risk_free = parse_number_param("risk_free", *v);
+        if (auto v = params.get("capital"))
+            capital = parse_number_param("capital", *v);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+
+    try
+    {
+        std::string missing;
+        auto series = backtest_series(settings.symbols, missing);
+        if (!missing.empty())
+        {
+            return send(not_found(req, missing));
+        }
+
+        std::optional<backtest_universe> universe;
+        std::vector<double> normalized;
+        try
+        {
+            universe.emplace(series, settings.from, settings.to, settings.rebalance);
+            normalized = universe->normalize(weights);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return send(bad_request(req, e.what()));
+        }
+
+        std::vector<double> equity;
+        backtest_summary summary = universe->run(normalized.data(), settings.risk_free, &equity);
+        const auto &days = universe->days();
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        res.body().reserve(256 + days.size() * 48);
+        envelope_writer env(res.body());
+        json_writer &w = env.data();
+        w.begin_object();
+        w.key("capital").value(capital);
+        w.key("equity").begin_array();
+        for (std::size_t i = 0; i < days.size(); ++i)
+        {
+            w.begin_object();
+            w.key("Date").value(format_day(days[i]));
+            w.key("Value").value(equity[i] * capital);
+            w.end_object();
+        }
+        w.end_array();
+        w.key("from").value(format_day(days.front()));
+        w.key("observations").value(days.size() - 1);
+        w.key("rebalance").value(rebalance_period_name(settings.rebalance));
+        w.key("summary");
+        write_backtest_summary(w, summary);
+        w.key("symbols").begin_array();
+        for (const auto &s : universe->symbol_names())
+            w.value(s);
+        w.end_array();
+        w.key("to").value(format_day(days.back()));
+        w.key("weights").begin_array();
+        for (double x : normalized)
+            w.value(x);
+        w.end_array();
+        w.end_object();
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
+
+// POST /api/backtest
+// {"symbols":["spy_etf","meta_stock"],"weights":[[0.6,0.4],[0.5,0.5],...],
+//  "from":"2010-01-01","to":"2014-12-31","rebalance":"monthly","risk_free":0.02}
+// Parameter sweep: every weight vector is run against the same aligned
+// universe in parallel and only the summaries are returned, in order.
+template <class Body, class Allocator, class Send>
+void handle_backtest_batch_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send)
+{
+    spdlog::info("Handling /api/backtest batch route");
+
+    backtest_request settings;
+    std::vector<double> weights;
+    std::size_t count = 0;
+    try
+    {
+        json body;
+        try
+        {
+            body = json::parse(req.body());
+        }
+        catch (const std::exception &)
+        {
+            throw std::invalid_argument("Invalid JSON format.");
+        }
+        if (!body.is_object() || !body.contains("symbols") || !body.contains("weights"))
+            throw std::invalid_argument("Expected an object with symbols and weights");
+
+        for (const auto &s : body.at("symbols"))
+        {
+            std::string name = s.get<std::string>();
+            if (!symbol_store::is_valid_symbol(name))
+                throw std::invalid_argument("Invalid symbol: '" + name + "'");
+            settings.symbols.push_back(std::move(name));
+        }
+        const json &rows = body.at("weights");
+        if (!rows.is_array() || rows.empty())
+            throw std::invalid_argument("weights must be a non-empty array of arrays");
+        if (rows.size() > backtest_max_batch)
+            throw std::invalid_argument("At most " + std::to_string(backtest_max_batch) +
+                                        " weight vectors per batch");
+        count = rows.size();
+        weights.reserve(count * settings.symbols.size());
+        for (const auto &row : rows)
+        {
+            if (!row.is_array() || row.size() != settings.symbols.size())
+                throw std::invalid_argument("Each weight vector needs one weight per symbol");
+            for (const auto &x : row)
+                weights.push_back(x.get<double>());
+        }
+        if (auto it = body.find("from"); it != body.end())
+            settings.from = parse_day(it->get<std::string>());
+        if (auto it = body.find("to"); it != body.end())
+            settings.to = parse_day(it->get<std::string>());
+        if (auto it = body.find("rebalance"); it != body.end())
+            settings.rebalance = parse_rebalance_period(it->get<std::string>());
+        if (auto it = body.find("risk_free"); it != body.end())
+            settings.risk_free = it->get<double>();
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+    catch (const json::exception &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+
+    try
+    {
+        std::string missing;
+        auto series = backtest_series(settings.symbols, missing);
+        if (!missing.empty())
+        {
+            return send(not_found(req, missing));
+        }
+
+        std::optional<backtest_universe> universe;
+        try
+        {
+            universe.emplace(series, settings.from, settings.to, settings.rebalance);
+            const std::size_t n = universe->symbols();
+            std::vector<double> row(n);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                std::copy_n(weights.begin() + i * n, n, row.begin());
+                row = universe->normalize(row);
+                std::copy_n(row.begin(), n, weights.begin() + i * n);
+            }
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return send(bad_request(req, e.what()));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<backtest_summary> results = universe->run_batch(weights, count, settings.risk_free);
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        spdlog::info("/api/backtest ran {} weight vectors in {:.2f} ms", count, elapsed.count());
+
+        const auto &days = universe->days();
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        res.body().reserve(256 + count * 128);
+        envelope_writer env(res.body());
+        json_writer &w = env.data();
+        w.begin_object();
+        w.key("count").value(count);
+        w.key("from").value(format_day(days.front()));
+        w.key("observations").value(days.size() - 1);
+        w.key("rebalance").value(rebalance_period_name(settings.rebalance));
+        w.key("results").begin_array();
+        for (const auto &r : results)
+            write_backtest_summary(w, r);
+        w.end_array();
+        w.key("symbols").begin_array();
+        for (const auto &s : universe->symbol_names())
+            w.value(s);
+        w.end_array();
+        w.key("to").value(format_day(days.back()));
+        w.end_object();
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
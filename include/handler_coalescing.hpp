@@ -0,0 +1,61 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "request_coalescer.hpp"
+#include "symbol_store.hpp"
+#include "envelope_writer.hpp"
+
+// GET /api/coalescing
+// Single-flight counters since startup: per route, the responses computed
+// ("executed"), the requests that shared one already being computed
+// ("coalesced") and the computations running now; plus the same for cold
+// symbol loads
+template <class Body, class Allocator, class Send>
+void handle_coalescing_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send)
+{
+    spdlog::info("Handling /api/coalescing route");
+    try
+    {
+        const auto routes = request_coalescer::getInstance().stats();
+        const symbol_cache_stats loads = symbol_store::getInstance().cache_stats();
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        envelope_writer env(res.body());
+        json_writer &w = env.data();
+        w.begin_object();
+        w.key("routes").begin_array();
+        for (const auto &[route, stats] : routes)
+        {
+            w.begin_object();
+            w.key("coalesced").value(stats.coalesced);
+            w.key("executed").value(stats.executed);
+            w.key("in_flight").value(stats.in_flight);
+            w.key("route").value(route);
+            w.end_object();
+        }
+        w.end_array();
+        w.key("symbol_loads").begin_object();
+        w.key("coalesced").value(loads.coalesced_loads);
+        w.key("executed").value(loads.loads);
+        w.end_object();
+        w.end_object();
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "connection_pool.hpp"
+#include "envelope_writer.hpp"
+
+// GET /api/connections
+// Open sessions and the connection pools' occupancy, summed over io threads:
+// cached arenas and their block bytes and, per block size, the free blocks held and how many
+// allocations were served from the cache ("reused") or the heap ("fresh")
+template <class Body, class Allocator, class Send>
+void handle_connections_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send)
+{
+    spdlog::info("Handling /api/connections route");
+    try
+    {
+        const connection_pool_stats stats = connection_pool::stats();
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        envelope_writer env(res.body());
+        json_writer &w = env.data();
+        w.begin_object();
+        w.key("arenas").begin_object();
+        w.key("cached").value(stats.arenas_cached);
+        w.key("cached_bytes").value(stats.arenas_cached_bytes);
+        w.key("fresh").value(stats.arenas_fresh);
+        w.key("reused").value(stats.arenas_reused);
+        w.end_object();
+        w.key("blocks").begin_array();
+        for (const auto &c : stats.classes)
+        {
+            // Sizes nothing was allocated in are left out
+            if (c.reused == 0 && c.fresh == 0 && c.cached == 0)
+                continue;
+            w.begin_object();
+            w.key("bytes").value(c.bytes);
+            w.key("cached").value(c.cached);
+            w.key("fresh").value(c.fresh);
+            w.key("reused").value(c.reused);
+            w.end_object();
+        }
+        w.end_array();
+        w.key("sessions").value(stats.live_sessions);
+        w.key("threads").value(stats.threads);
+        w.end_object();
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "symbol_store.hpp"
+#include "series_correlation.hpp"
+#include "query_params.hpp"
+#include "date_utils.hpp"
+#include "envelope_writer.hpp"
+
+// GET /api/correlation?symbols=spy_etf,meta_stock&from=&to=
+// Correlation and covariance matrices of daily returns, aligned on the
+// dates all symbols share. Without ?symbols= every resident symbol is used.
+template <class Body, class Allocator, class Send>
+void handle_correlation_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send,
+    const query_params &params)
+{
+    spdlog::info("Handling /api/correlation route");
+
+    std::optional<std::int32_t> from;
+    std::optional<std::int32_t> to;
+    std::vector<std::string> symbols;
+    try
+    {
+        if (auto v = params.get("from"))
+            from = parse_day(*v);
+        if (auto v = params.get("to"))
+            to = parse_day(*v);
+        if (auto v = params.get("symbols"))
+        {
+            std::string_view list = *v;
+            while (!list.empty())
+            {
+                auto comma = list.find(',');
+                std::string name(list.substr(0, comma));
+                list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+                if (!symbol_store::is_valid_symbol(name))
+                    throw std::invalid_argument("Invalid symbol: '" + name + "'");
+                symbols.push_back(std::move(name));
+            }
+        }
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+
+    try
+    {
+        symbol_store &store = symbol_store::getInstance();
+        if (symbols.empty())
+            symbols = store.symbols();
+
+        std::vector<std::shared_ptr<const price_series>> series;
+        series.reserve(symbols.size());
+        for (const auto &name : symbols)
+        {
+            auto s = store.get(name);
+            if (!s)
+            {
+                return send(not_found(req, name));
+            }
+            series.push_back(std::move(s));
+        }
+
+        correlation_matrix matrix;
+        try
+        {
+            matrix = compute_correlation_matrix(series, from, to);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return send(bad_request(req, e.what()));
+        }
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        envelope_writer env(res.body());
+        write_correlation_matrix(env.data(), matrix);
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
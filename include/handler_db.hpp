@@ -10,6 +10,7 @@
 #include "csv_loader.hpp"
 #include "StockPrice.hpp"
 #include "ResponseHelper.hpp"
+#include "request_coalescer.hpp"
 
 using json = nlohmann::json;
 
@@ -22,38 +23,30 @@ void handle_db_route(
     spdlog::info("Handling /db route");
     try
     {
-        json data = db->getData();
-        spdlog::info("Database returned data");
-
-        StandardResponse res_struct = create_success_response(200, data);
-        json res_json = res_struct.to_json();
-
-        std::string response_body = res_json.dump();
-
-        http::response<http::string_body> res{
-            http::status::ok, req.version()};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::content_type, "application/json");
-        res.keep_alive(req.keep_alive());
-        res.body() = response_body;
-        res.prepare_payload();
-        spdlog::info("/db response sent");
-        return send(std::move(res));
+        // Requests arriving while a query runs share its result rather than
+        // queue further queries on the connection
+        return send_coalesced("/db", "/db", req, send, [&db] {
+            json data = db->getData();
+            spdlog::info("Database returned data");
+
+            StandardResponse res_struct = create_success_response(200, std::move(data));
+            coalesced_response out;
+            res_struct.write_json(out.body);
+            return out;
+        });
     }
     catch (const std::exception &e)
     {
         spdlog::error("Database error: {}", e.what());
 
         StandardResponse res_struct = create_internal_server_error_response(e.what());
-        json res_json = res_struct.to_json();
-        std::string response_body = res_json.dump();
 
         http::response<http::string_body> res{
             http::status::internal_server_error, req.version()};
         res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
         res.set(http::field::content_type, "application/json");
         res.keep_alive(req.keep_alive());
-        res.body() = response_body;
+        res_struct.write_json(res.body());
         res.prepare_payload();
         spdlog::info("/db error response sent");
         return send(std::move(res));
@@ -17,15 +17,14 @@ void handle_hello_route(
     json data = {
         {"message", "Hello world why"}};
 
-    StandardResponse res_struct = create_success_response(200, data);
-    json res_json = res_struct.to_json();
+    StandardResponse res_struct = create_success_response(200, std::move(data));
 
     http::response<http::string_body> res{
         http::status::ok, req.version()};
     res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
     res.set(boost::beast::http::field::content_type, "application/json");
     res.keep_alive(req.keep_alive());
-    res.body() = res_json.dump();
+    res_struct.write_json(res.body());
     res.prepare_payload();
 
     spdlog::info("/hello response sent");
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "symbol_store.hpp"
+#include "series_query.hpp"
+#include "indicators.hpp"
+#include "query_params.hpp"
+#include "date_utils.hpp"
+#include "envelope_writer.hpp"
+
+// GET /api/indicators/<symbol>?name=ema&period=20&from=&to=
+//     name=sma|ema|rsi (period), macd (fast, slow, signal),
+//     bollinger (period, k)
+// One indicator over the closes, oldest first. Values come from the
+// indicator cache: computed once per symbol and parameter set, then only
+// extended by the rows appended since; "cache" reports which happened.
+template <class Body, class Allocator, class Send>
+void handle_indicators_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send,
+    const std::string &symbol,
+    const query_params &params)
+{
+    spdlog::info("Handling /api/indicators route for symbol: {}", symbol);
+    if (!symbol_store::is_valid_symbol(symbol))
+    {
+        return send(bad_request(req, "Invalid symbol."));
+    }
+
+    indicator_spec spec;
+    std::optional<std::int32_t> from;
+    std::optional<std::int32_t> to;
+    try
+    {
+        auto name = params.get("name");
+        if (!name)
+            throw std::invalid_argument("Missing name, e.g. ?name=ema&period=20");
+        spec = indicator_spec::defaults(parse_indicator_kind(*name));
+        if (auto v = params.get("period"))
+            spec.period = parse_count_param("period", *v);
+        if (auto v = params.get("fast"))
+            spec.fast = parse_count_param("fast", *v);
+        if (auto v = params.get("slow"))
+            spec.slow = parse_count_param("slow", *v);
+        if (auto v = params.get("signal"))
+            spec.signal = parse_count_param("signal", *v);
+        if (auto v = params.get("k"))
+            spec.width = parse_number_param("k", *v);
+        spec.validate();
+        if (auto v = params.get("from"))
+            from = parse_day(*v);
+        if (auto v = params.get("to"))
+            to = parse_day(*v);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+
+    try
+    {
+        std::shared_ptr<const price_series> series = symbol_store::getInstance().get(symbol);
+        if (!series)
+        {
+            return send(not_found(req, req.target()));
+        }
+
+        indicator_view view = indicator_cache::getInstance().compute(symbol, *series, spec);
+        const indicator_series &ind = *view.entry;
+        row_range range = find_day_range(*series, from, to);
+        const std::size_t rows = range.empty() ? 0 : range.size();
+        const std::size_t outputs = spec.outputs();
+        const char *const *names = spec.output_names();
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        res.body().reserve(256 + rows * (24 + outputs * 28));
+        envelope_writer env(res.body());
+        json_writer &w = env.data();
+        w.begin_object();
+        w.key("cache").value(view.cache);
+        if (range.empty())
+            w.key("from").null();
+        else
+            w.key("from").value(format_day(series->day[range.begin]));
+        w.key("indicator").value(spec.key());
+        w.key("name").value(indicator_kind_name(spec.kind));
+        w.key("rows").value(rows);
+        w.key("symbol").value(symbol);
+        if (range.empty())
+            w.key("to").null();
+        else
+            w.key("to").value(format_day(series->day[range.end - 1]));
+        w.key("values").begin_array();
+        for (std::size_t i = range.begin; i < range.begin + rows; ++i)
+        {
+            const double *v = ind.row(i);
+            w.begin_object();
+            w.key("Date").value(format_day(series->day[i]));
+            for (std::size_t j = 0; j < outputs; ++j)
+                w.key(names[j]).value(v[j]);
+            w.end_object();
+        }
+        w.end_array();
+        w.end_object();
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
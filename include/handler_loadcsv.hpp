@@ -6,42 +6,172 @@
 #include <nlohmann/json.hpp>
 #include "StandardResponse.hpp"
 #include <spdlog/spdlog.h>
-#include "IDatabase.hpp"
-#include "csv_loader.hpp"
 #include "StockPrice.hpp"
 #include "ResponseHelper.hpp"
+#include "request_utils.hpp"
+#include "symbol_store.hpp"
+#include "series_query.hpp"
+#include "series_pyramid.hpp"
+#include "query_params.hpp"
+#include "date_utils.hpp"
+#include "chunked_body.hpp"
+#include "envelope_writer.hpp"
+#include "request_coalescer.hpp"
 
 using json = nlohmann::json;
 
+// Responses with at least this many rows (some 12 MB of JSON) are streamed
+// with chunked encoding unless the client passes ?stream=0. Smaller ones are
+// serialized whole, so a burst of identical requests shares one body.
+constexpr std::size_t loadcsv_stream_min_rows = 100000;
+
 template <class Body, class Allocator, class Send>
 void handle_loadcsv_route(
     http::request<Body, http::basic_fields<Allocator>> &&req,
     Send &&send,
-    std::shared_ptr<IDatabase> db, const std::string &file_name)
+    const std::string &file_name,
+    const query_params &params = query_params{})
 {
     spdlog::info("Handling /loadcsv route for file: {}", file_name);
+    if (!symbol_store::is_valid_symbol(file_name))
+    {
+        return send(bad_request(req, "Invalid symbol."));
+    }
+
+    // Optional ?from=&to= (dd/mm/yyyy or yyyy-mm-dd) and ?fields=Price,High
+    std::optional<std::int32_t> from;
+    std::optional<std::int32_t> to;
+    unsigned fields = field_all;
+    // ?points=N caps the rows for an N-pixel chart; ?downsample=lttb picks
+    // daily rows instead of weekly/monthly bars
+    std::optional<std::size_t> points;
+    bool lttb = false;
     try
     {
-        // Create a file path based on the file name
-        std::string file_path = "../data/" + file_name + ".csv";
+        if (auto v = params.get("from"))
+            from = parse_day(*v);
+        if (auto v = params.get("to"))
+            to = parse_day(*v);
+        if (auto v = params.get("fields"))
+            fields = parse_series_fields(*v);
+        if (auto v = params.get("points"))
+            points = parse_count_param("points", *v);
+        if (auto v = params.get("downsample"))
+        {
+            if (*v == "lttb")
+                lttb = true;
+            else if (*v != "ohlc")
+                throw std::invalid_argument("Unknown downsample: " + std::string(*v));
+        }
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
 
-        // Load the CSV content using the separated function and StockPrice mapping
-        std::vector<StockPrice> stock_data = load_csv<StockPrice>(file_path, map_to_stock_price);
-        json response_data = stock_data;
+    try
+    {
+        // Served from the resident store; the CSV is only parsed on first use
+        std::shared_ptr<const price_series> series = symbol_store::getInstance().get(file_name);
+        if (!series)
+        {
+            return send(not_found(req, req.target()));
+        }
 
-        StandardResponse res_struct = create_success_response(200, response_data);
-        json res_json = res_struct.to_json();
+        row_range range = find_day_range(*series, from, to);
 
-        http::response<http::string_body> res{
-            http::status::ok, req.version()};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::content_type, "application/json");
-        res.keep_alive(req.keep_alive());
-        res.body() = res_json.dump();
-        res.prepare_payload();
+        // Identical requests for the same version of the series share one
+        // serialized body
+        const std::string flight_key = std::string(req.target()) + '#' + std::to_string(series->lineage) + ':' +
+                                       std::to_string(series->size());
 
-        spdlog::info("/loadcsv response sent");
-        return send(std::move(res));
+        if (points && range.size() > *points)
+        {
+            return send_coalesced("/loadcsv", flight_key, req, send, [&] {
+                // The finest pyramid level that fits, reduced further by LTTB
+                // when even monthly bars are too many. Until the pyramid of a
+                // mapped snapshot is built, daily rows are reduced directly.
+                const price_series *rows = series.get();
+                series_resolution resolution = series_resolution::daily;
+                row_range selected = range;
+                if (!lttb && series->pyramid)
+                {
+                    for (auto level : {series_resolution::weekly, series_resolution::monthly})
+                    {
+                        rows = &series->pyramid->bars(level);
+                        resolution = level;
+                        selected = series->pyramid->bars_covering(level, range);
+                        if (selected.size() <= *points)
+                            break;
+                    }
+                }
+                std::vector<std::size_t> picked = lttb_downsample(*rows, selected, *points);
+
+                coalesced_response out;
+                std::string resolution_name = series_resolution_name(resolution);
+                if (picked.size() < selected.size())
+                    resolution_name += "; lttb";
+                out.fields.emplace_back("X-Resolution", resolution_name);
+
+                out.body.reserve(64 + picked.size() * 128);
+                envelope_writer env(out.body);
+                json_writer &w = env.data();
+                w.begin_array();
+                for (auto i = picked.rbegin(); i != picked.rend(); ++i)
+                {
+                    write_series_row(w, *rows, *i, fields);
+                }
+                w.end_array();
+                env.finish(true, 200);
+                spdlog::info("/loadcsv sent {} of {} rows ({})", picked.size(), range.size(), resolution_name);
+                return out;
+            });
+        }
+
+        bool stream = range.size() >= loadcsv_stream_min_rows;
+        if (auto v = params.get("stream"))
+            stream = (*v == "1" || *v == "true");
+
+        if (stream)
+        {
+            // Rows are serialized as the socket drains, so memory per request
+            // stays at one chunk regardless of the series length
+            http::response<generator_body> res{
+                http::status::ok, req.version()};
+            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            res.set(http::field::content_type, "application/json");
+            res.body().next = series_json_stream(series, range, fields);
+            if (req.version() >= 11)
+            {
+                res.keep_alive(req.keep_alive());
+                res.chunked(true);
+            }
+            else
+            {
+                // HTTP/1.0 has no chunked encoding; the body ends at close
+                res.keep_alive(false);
+            }
+
+            spdlog::info("/loadcsv streaming {} rows", range.size());
+            return send(std::move(res));
+        }
+
+        return send_coalesced("/loadcsv", flight_key, req, send, [&] {
+            // Rows are written straight into the body, newest first, matching
+            // the order of the source files
+            coalesced_response out;
+            out.body.reserve(64 + range.size() * 128);
+            envelope_writer env(out.body);
+            json_writer &rows = env.data();
+            rows.begin_array();
+            for (std::size_t i = range.end; i-- > range.begin;)
+            {
+                write_series_row(rows, *series, i, fields);
+            }
+            rows.end_array();
+            env.finish(true, 200);
+            return out;
+        });
     }
     catch (const std::exception &e)
     {
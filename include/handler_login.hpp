@@ -20,7 +20,7 @@ template <class Body, class Allocator, class Send>
 void handle_login_route(
     http::request<Body, http::basic_fields<Allocator>> &&req,
     Send &&send,
-    std::shared_ptr<IDatabase> db)
+    [[maybe_unused]] std::shared_ptr<IDatabase> db)
 {
     spdlog::info("Handling /login route");
 
@@ -62,13 +62,12 @@ void handle_login_route(
     {
         spdlog::warn("Authentication failed for user: {}", username);
         StandardResponse res_struct = create_error_response(401, "Invalid credentials.", "Unauthorized");
-        json res_json = res_struct.to_json();
         http::response<http::string_body> res{
             http::status::unauthorized, req.version()};
         res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
         res.set(http::field::content_type, "application/json");
         res.keep_alive(req.keep_alive());
-        res.body() = res_json.dump();
+        res_struct.write_json(res.body());
         res.prepare_payload();
         return send(std::move(res));
     }
@@ -87,14 +86,13 @@ void handle_login_route(
     json data = {
         {"token", token}};
 
-    StandardResponse res_struct = create_success_response(200, data);
-    json res_json = res_struct.to_json();
+    StandardResponse res_struct = create_success_response(200, std::move(data));
     http::response<http::string_body> res{
         http::status::ok, req.version()};
     res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
     res.set(http::field::content_type, "application/json");
     res.keep_alive(req.keep_alive());
-    res.body() = res_json.dump();
+    res_struct.write_json(res.body());
     res.prepare_payload();
     spdlog::info("/login response sent");
     return send(std::move(res));
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "symbol_store.hpp"
+#include "series_query.hpp"
+#include "return_sketches.hpp"
+#include "query_params.hpp"
+#include "date_utils.hpp"
+#include "envelope_writer.hpp"
+
+// Most quantiles one request may ask for
+constexpr std::size_t quantiles_max_levels = 100;
+
+// Writes {"count":..,"exact":..,"quantiles":[{"q":..,"rank_error":..,"value":..}]}
+// without closing the object, so callers can add keys that sort later
+inline void write_quantile_summary(json_writer &w, const tdigest &digest, const std::vector<double> &levels)
+{
+    w.key("count").value(static_cast<std::size_t>(digest.count()));
+    w.key("exact").value(digest.exact());
+    w.key("quantiles").begin_array();
+    for (double q : levels)
+    {
+        w.begin_object();
+        w.key("q").value(q);
+        w.key("rank_error").value(digest.rank_error(q));
+        w.key("value").value(digest.quantile(q));
+        w.end_object();
+    }
+    w.end_array();
+}
+
+// GET /api/quantiles?symbols=spy_etf,meta_stock&q=0.01,0.05,0.5&from=&to=
+// Percentiles of daily ChangePercent over the window, per symbol and pooled
+// across the symbols, merged from the per-year t-digests built at load.
+// rank_error bounds how far, in quantile terms, each value may be off;
+// "exact" means the window was small enough that no values were merged.
+// Without ?symbols= every resident symbol is used.
+template <class Body, class Allocator, class Send>
+void handle_quantiles_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send,
+    const query_params &params)
+{
+    spdlog::info("Handling /api/quantiles route");
+
+    std::optional<std::int32_t> from;
+    std::optional<std::int32_t> to;
+    std::vector<std::string> symbols;
+    std::vector<double> levels = {0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99};
+    try
+    {
+        if (auto v = params.get("from"))
+            from = parse_day(*v);
+        if (auto v = params.get("to"))
+            to = parse_day(*v);
+        if (auto v = params.get("symbols"))
+        {
+            std::string_view list = *v;
+            while (!list.empty())
+            {
+                auto comma = list.find(',');
+                std::string name(list.substr(0, comma));
+                list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+                if (!symbol_store::is_valid_symbol(name))
+                    throw std::invalid_argument("Invalid symbol: '" + name + "'");
+                symbols.push_back(std::move(name));
+            }
+        }
+        if (auto v = params.get("q"))
+        {
+            levels.clear();
+            std::string_view list = *v;
+            while (!list.empty())
+            {
+                auto comma = list.find(',');
+                double q = parse_number_param("q", list.substr(0, comma));
+                list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+                if (q < 0.0 || q > 1.0)
+                    throw std::invalid_argument("q must be between 0 and 1");
+                levels.push_back(q);
+            }
+            if (levels.empty() || levels.size() > quantiles_max_levels)
+                throw std::invalid_argument("Between 1 and " + std::to_string(quantiles_max_levels) +
+                                            " quantiles may be requested");
+        }
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+
+    try
+    {
+        symbol_store &store = symbol_store::getInstance();
+        if (symbols.empty())
+            symbols = store.symbols();
+
+        std::vector<tdigest> digests(symbols.size());
+        std::vector<std::size_t> sketch_bytes(symbols.size());
+        tdigest pooled;
+        for (std::size_t i = 0; i < symbols.size(); ++i)
+        {
+            auto series = store.get(symbols[i]);
+            if (!series)
+            {
+                return send(not_found(req, symbols[i]));
+            }
+            add_change_percents(*series, find_day_range(*series, from, to), digests[i]);
+            sketch_bytes[i] = series->sketches ? series->sketches->memory_bytes() : 0;
+            digests[i].compress();
+            pooled.merge(digests[i]);
+        }
+        pooled.compress();
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        res.body().reserve(256 + (symbols.size() + 1) * (64 + levels.size() * 80));
+        envelope_writer env(res.body());
+        json_writer &w = env.data();
+        w.begin_object();
+        w.key("compression").value(tdigest::default_compression);
+        w.key("pooled").begin_object();
+        write_quantile_summary(w, pooled, levels);
+        w.end_object();
+        w.key("symbols").begin_array();
+        for (std::size_t i = 0; i < symbols.size(); ++i)
+        {
+            w.begin_object();
+            write_quantile_summary(w, digests[i], levels);
+            w.key("sketch_bytes").value(sketch_bytes[i]);
+            w.key("symbol").value(symbols[i]);
+            w.end_object();
+        }
+        w.end_array();
+        w.end_object();
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
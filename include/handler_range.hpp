@@ -0,0 +1,113 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "symbol_store.hpp"
+#include "series_query.hpp"
+#include "range_index.hpp"
+#include "query_params.hpp"
+#include "date_utils.hpp"
+#include "envelope_writer.hpp"
+
+// GET /api/range/<symbol>?from=&to=&fields=Price,High,Low
+// Count, sum, mean, variance/stddev, min and max of each selected column over
+// the date window, answered from the symbol's range index without touching
+// the rows in between. Without ?fields= every indexed column is returned.
+template <class Body, class Allocator, class Send>
+void handle_range_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send,
+    const std::string &symbol,
+    const query_params &params)
+{
+    spdlog::info("Handling /api/range route for symbol: {}", symbol);
+    if (!symbol_store::is_valid_symbol(symbol))
+    {
+        return send(bad_request(req, "Invalid symbol."));
+    }
+
+    std::optional<std::int32_t> from;
+    std::optional<std::int32_t> to;
+    unsigned fields = range_index::indexed_fields;
+    try
+    {
+        if (auto v = params.get("from"))
+            from = parse_day(*v);
+        if (auto v = params.get("to"))
+            to = parse_day(*v);
+        if (auto v = params.get("fields"))
+        {
+            fields = parse_series_fields(*v) & ~field_date;
+            if (fields & ~range_index::indexed_fields)
+                throw std::invalid_argument("Volume has no range aggregates");
+            if (fields == 0)
+                throw std::invalid_argument("No columns selected");
+        }
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+
+    try
+    {
+        std::shared_ptr<const price_series> series = symbol_store::getInstance().get(symbol);
+        if (!series)
+        {
+            return send(not_found(req, req.target()));
+        }
+
+        row_range range = find_day_range(*series, from, to);
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        // Keys in sorted order, as in the other JSON responses
+        static constexpr std::pair<const char *, series_field> columns[] = {
+            {"ChangePercent", field_change_percent},
+            {"High", field_high},
+            {"Low", field_low},
+            {"Open", field_open},
+            {"Price", field_price},
+        };
+
+        envelope_writer env(res.body());
+        json_writer &w = env.data();
+        w.begin_object();
+        w.key("columns").begin_object();
+        for (const auto &[name, field] : columns)
+        {
+            if (fields & field)
+            {
+                w.key(name);
+                write_range_aggregate(w, aggregate_range(*series, field, range));
+            }
+        }
+        w.end_object();
+        if (range.empty())
+            w.key("from").null();
+        else
+            w.key("from").value(format_day(series->day[range.begin]));
+        w.key("indexed").value(series->index != nullptr);
+        w.key("rows").value(range.empty() ? std::size_t{0} : range.size());
+        w.key("symbol").value(symbol);
+        if (range.empty())
+            w.key("to").null();
+        else
+            w.key("to").value(format_day(series->day[range.end - 1]));
+        w.end_object();
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
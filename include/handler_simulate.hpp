@@ -0,0 +1,99 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <charconv>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "symbol_store.hpp"
+#include "series_query.hpp"
+#include "monte_carlo.hpp"
+#include "query_params.hpp"
+#include "date_utils.hpp"
+#include "envelope_writer.hpp"
+
+// GET /api/simulate/<symbol>?method=bootstrap|gbm&paths=&horizon=&seed=&from=&to=
+// Monte Carlo paths of 1.0 invested over horizon trading days, driven by the
+// daily returns of the [from, to] history. Only quantiles of the terminal
+// value and of each path's max drawdown are returned. The same seed gives
+// the same answer on any machine and thread count.
+template <class Body, class Allocator, class Send>
+void handle_simulate_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send,
+    const std::string &symbol,
+    const query_params &params)
+{
+    spdlog::info("Handling /api/simulate route for symbol: {}", symbol);
+    if (!symbol_store::is_valid_symbol(symbol))
+    {
+        return send(bad_request(req, "Invalid symbol."));
+    }
+
+    std::optional<std::int32_t> from;
+    std::optional<std::int32_t> to;
+    simulation_request request;
+    try
+    {
+        if (auto v = params.get("from"))
+            from = parse_day(*v);
+        if (auto v = params.get("to"))
+            to = parse_day(*v);
+        if (auto v = params.get("method"))
+            request.method = parse_simulation_method(*v);
+        if (auto v = params.get("paths"))
+            request.paths = parse_count_param("paths", *v);
+        if (auto v = params.get("horizon"))
+            request.horizon = parse_count_param("horizon", *v);
+        if (auto v = params.get("seed"))
+        {
+            auto [ptr, ec] = std::from_chars(v->data(), v->data() + v->size(), request.seed);
+            if (ec != std::errc() || ptr != v->data() + v->size())
+                throw std::invalid_argument("Invalid seed: '" + std::string(*v) + "'");
+        }
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+
+    try
+    {
+        std::shared_ptr<const price_series> series = symbol_store::getInstance().get(symbol);
+        if (!series)
+        {
+            return send(not_found(req, req.target()));
+        }
+
+        row_range range = find_day_range(*series, from, to);
+        simulation_result result;
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            result = run_simulation(*series, range, request);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return send(bad_request(req, e.what()));
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        spdlog::info("/api/simulate ran {} paths x {} days in {:.2f} ms", request.paths, request.horizon, elapsed.count());
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        envelope_writer env(res.body());
+        write_simulation_result(env.data(), symbol, request, result);
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "symbol_store.hpp"
+#include "series_query.hpp"
+#include "series_stats.hpp"
+#include "query_params.hpp"
+#include "date_utils.hpp"
+#include "envelope_writer.hpp"
+
+// Rolling window used when the client does not pass ?window=
+constexpr std::size_t stats_default_window = 20;
+
+// GET /api/stats/<symbol>?from=&to=&window=&kernel=
+// Returns, volatility, rolling window and drawdown statistics computed over
+// the resident series; the response is a single small object.
+template <class Body, class Allocator, class Send>
+void handle_stats_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send,
+    const std::string &symbol,
+    const query_params &params)
+{
+    spdlog::info("Handling /api/stats route for symbol: {}", symbol);
+    if (!symbol_store::is_valid_symbol(symbol))
+    {
+        return send(bad_request(req, "Invalid symbol."));
+    }
+
+    std::optional<std::int32_t> from;
+    std::optional<std::int32_t> to;
+    std::size_t window = stats_default_window;
+    simd_level level = best_simd_level();
+    try
+    {
+        if (auto v = params.get("from"))
+            from = parse_day(*v);
+        if (auto v = params.get("to"))
+            to = parse_day(*v);
+        if (auto v = params.get("window"))
+            window = parse_count_param("window", *v);
+        // ?kernel= selects a narrower kernel set, for comparing results
+        if (auto v = params.get("kernel"))
+        {
+            if (*v == "scalar")
+                level = simd_level::scalar;
+            else if (*v == "sse2")
+                level = simd_level::sse2;
+            else if (*v != "avx2")
+                throw std::invalid_argument("Unknown kernel: " + std::string(*v));
+        }
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+
+    try
+    {
+        std::shared_ptr<const price_series> series = symbol_store::getInstance().get(symbol);
+        if (!series)
+        {
+            return send(not_found(req, req.target()));
+        }
+
+        row_range range = find_day_range(*series, from, to);
+        series_stats stats;
+        try
+        {
+            stats = compute_series_stats(*series, range, window, level);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return send(bad_request(req, e.what()));
+        }
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        envelope_writer env(res.body());
+        write_series_stats(env.data(), symbol, stats);
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <spdlog/spdlog.h>
+#include "request_utils.hpp"
+#include "symbol_store.hpp"
+#include "query_params.hpp"
+#include "envelope_writer.hpp"
+
+// Symbols one page may list, and the default page size
+constexpr std::size_t symbols_max_limit = 10000;
+constexpr std::size_t symbols_default_limit = 1000;
+
+// GET /api/symbols?prefix=&after=&limit=
+// Cataloged symbols in name order, whether resident or not, with the rows
+// and estimated bytes of the resident ones, plus the symbol cache counters.
+// Pages are keyed by name: pass the previous page's "next" as ?after= to
+// continue; "next" is null on the last page. Listing does not load anything.
+template <class Body, class Allocator, class Send>
+void handle_symbols_route(
+    http::request<Body, http::basic_fields<Allocator>> &&req,
+    Send &&send,
+    const query_params &params)
+{
+    spdlog::info("Handling /api/symbols route");
+
+    std::string prefix;
+    std::string after;
+    std::size_t limit = symbols_default_limit;
+    try
+    {
+        if (auto v = params.get("prefix"))
+            prefix = std::string(*v);
+        if (auto v = params.get("after"))
+            after = std::string(*v);
+        if (auto v = params.get("limit"))
+            limit = parse_count_param("limit", *v);
+        if (limit > symbols_max_limit)
+            throw std::invalid_argument("limit may be at most " + std::to_string(symbols_max_limit));
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return send(bad_request(req, e.what()));
+    }
+
+    try
+    {
+        symbol_store &store = symbol_store::getInstance();
+        std::size_t total = 0;
+        std::vector<std::string> names = store.catalog(prefix, after, limit, &total);
+        // A full page leaves the rest to a following request
+        const bool more = names.size() == limit && !store.catalog(prefix, names.back(), 1).empty();
+        const symbol_cache_stats stats = store.cache_stats();
+
+        http::response<http::string_body> res{
+            http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+
+        res.body().reserve(512 + names.size() * 96);
+        envelope_writer env(res.body());
+        json_writer &w = env.data();
+        w.begin_object();
+        w.key("cache").begin_object();
+        w.key("bytes").value(stats.bytes);
+        w.key("capacity_bytes").value(stats.capacity);
+        w.key("coalesced_loads").value(stats.coalesced_loads);
+        w.key("evictions").value(stats.evictions);
+        const std::uint64_t lookups = stats.hits + stats.misses;
+        if (lookups == 0)
+            w.key("hit_rate").null();
+        else
+            w.key("hit_rate").value(static_cast<double>(stats.hits) / static_cast<double>(lookups));
+        w.key("hits").value(stats.hits);
+        w.key("loads").value(stats.loads);
+        w.key("misses").value(stats.misses);
+        w.key("resident").value(stats.resident);
+        w.key("shards").value(symbol_store::shard_count);
+        w.end_object();
+        w.key("count").value(total);
+        if (more)
+            w.key("next").value(names.back());
+        else
+            w.key("next").null();
+        w.key("symbols").begin_array();
+        for (const auto &name : names)
+        {
+            auto series = store.peek(name);
+            w.begin_object();
+            w.key("bytes").value(series ? symbol_store::resident_bytes(*series) : std::size_t{0});
+            w.key("resident").value(series != nullptr);
+            w.key("rows").value(series ? series->size() : std::size_t{0});
+            w.key("symbol").value(name);
+            w.end_object();
+        }
+        w.end_array();
+        w.end_object();
+        env.finish(true, 200);
+        res.prepare_payload();
+        return send(std::move(res));
+    }
+    catch (const std::exception &e)
+    {
+        return send(server_error(req, e.what()));
+    }
+}
@@ -0,0 +1,187 @@
+// indicators.hpp
+#ifndef INDICATORS_HPP
+#define INDICATORS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "price_series.hpp"
+
+// Technical indicators over the Price (close) column:
+//   sma(n)            mean of the last n closes
+//   ema(n)            exponential average, alpha = 2 / (n + 1), seeded with sma(n)
+//   rsi(n)            Wilder's relative strength index, 0 to 100
+//   macd(f,s,g)       ema(f) - ema(s), its ema(g) signal line and the histogram
+//   bollinger(n,k)    sma(n) and the bands k population stddevs above and below
+// Values are NaN (null in JSON) until enough rows have been seen.
+enum class indicator_kind { sma, ema, rsi, macd, bollinger };
+
+// Throws std::invalid_argument for an unknown name
+indicator_kind parse_indicator_kind(std::string_view name);
+const char* indicator_kind_name(indicator_kind kind) noexcept;
+
+// Longest window any parameter may ask for
+constexpr std::size_t indicator_max_period = 1000;
+
+struct indicator_spec {
+    indicator_kind kind = indicator_kind::sma;
+    std::size_t period = 20; // sma, ema, rsi, bollinger; macd uses fast/slow/signal
+    std::size_t fast = 12;
+    std::size_t slow = 26;
+    std::size_t signal = 9;
+    double width = 2.0;      // bollinger: stddevs from the middle band
+
+    // Spec with the conventional defaults of kind (rsi defaults to 14)
+    static indicator_spec defaults(indicator_kind kind) noexcept;
+
+    // Throws std::invalid_argument for a period outside 1..indicator_max_period,
+    // macd with fast >= slow, or a width that is not positive
+    void validate() const;
+
+    // Canonical name with the parameters that matter, e.g. "macd(12,26,9)";
+    // equal specs have equal keys
+    std::string key() const;
+
+    // Values per row, and their names in sorted order
+    std::size_t outputs() const noexcept;
+    const char* const* output_names() const noexcept;
+};
+
+// Running state of one indicator: each push() consumes the next close and
+// writes the indicator for that row in O(1), whatever the window length.
+class indicator_state {
+public:
+    explicit indicator_state(const indicator_spec& spec);
+
+    // Writes spec.outputs() values, in output_names() order
+    void push(double price, double* out);
+
+    std::size_t memory_bytes() const noexcept { return window_.capacity() * sizeof(double); }
+
+private:
+    // Exponential average seeded with the mean of its first n inputs
+    struct ema {
+        std::size_t n = 0;
+        std::size_t seen = 0;
+        double alpha = 0.0;
+        double value = 0.0;
+
+        explicit ema(std::size_t period = 1)
+            : n(period), alpha(2.0 / (static_cast<double>(period) + 1.0)) {}
+        bool ready() const noexcept { return seen >= n; }
+        // Returns the average after x, NaN while seeding
+        double push(double x) noexcept;
+    };
+
+    double push_window(double price) noexcept; // sma; keeps mean_ and m2_
+
+    indicator_spec spec_;
+    // sma and bollinger: ring buffer of the last period closes
+    std::vector<double> window_;
+    std::size_t next_ = 0;
+    std::size_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0; // sum of squared deviations from mean_ over the window
+    // ema and macd
+    ema fast_;
+    ema slow_;
+    ema signal_;
+    // rsi: Wilder-smoothed gains and losses
+    double previous_ = 0.0;
+    double gain_ = 0.0;
+    double loss_ = 0.0;
+};
+
+// An indicator computed over a prefix of one symbol's rows. Entries follow
+// the series' lineage (see price_series::lineage): while it is unchanged
+// the stored rows are still valid and only the new rows are pushed.
+struct indicator_series {
+    explicit indicator_series(const indicator_spec& spec) : spec(spec), state(spec) {}
+
+    // Brings the values up to series.size() rows: O(1) per appended row for
+    // the same lineage, a full recompute for a new one. Returns the rows
+    // pushed. Callers hold mutex exclusively.
+    std::size_t extend(const price_series& series);
+
+    // True when rows [0, series.size()) of series are already computed
+    bool covers(const price_series& series) const noexcept {
+        return lineage == series.lineage && rows >= series.size();
+    }
+
+    const double* row(std::size_t i) const noexcept { return values.data() + i * spec.outputs(); }
+    std::size_t memory_bytes() const noexcept;
+
+    mutable std::shared_mutex mutex;
+    const indicator_spec spec;
+    std::uint64_t lineage = 0;
+    std::size_t rows = 0;
+    std::vector<double> values; // rows x spec.outputs(), row-major
+    indicator_state state;
+};
+
+// An entry that covers a series, read-locked for as long as the view lives
+struct indicator_view {
+    std::shared_ptr<indicator_series> entry;
+    std::shared_lock<std::shared_mutex> lock;
+    const char* cache = "hit"; // "hit", "extended" or "computed"
+};
+
+// Process-wide LRU cache of indicator_series keyed by symbol and spec key,
+// bounded by the bytes of their values. Evicted entries stay valid for
+// requests that still hold them.
+class indicator_cache {
+public:
+    static indicator_cache& getInstance() {
+        static indicator_cache instance;
+        return instance;
+    }
+
+    indicator_cache(const indicator_cache&) = delete;
+    indicator_cache& operator=(const indicator_cache&) = delete;
+
+    // 0 disables caching: every lookup gets a fresh entry
+    void set_capacity_bytes(std::size_t bytes);
+
+    // Entry for (symbol, spec), created empty when absent, and marked most
+    // recently used
+    std::shared_ptr<indicator_series> get(const std::string& symbol, const indicator_spec& spec);
+
+    // Entry for (symbol, spec) brought up to date with series: served as is
+    // when it already covers series, extended by the appended rows when
+    // series continues its lineage, recomputed otherwise
+    indicator_view compute(const std::string& symbol, const price_series& series, const indicator_spec& spec);
+
+    // Records the current size of an entry returned by get() and evicts the
+    // least recently used others while over capacity
+    void update_size(const std::string& symbol, const indicator_series& entry);
+
+    std::size_t size() const;
+    std::size_t memory_bytes() const;
+
+private:
+    indicator_cache() = default;
+
+    struct node {
+        std::string key;
+        std::shared_ptr<indicator_series> entry;
+        std::size_t bytes = 0;
+    };
+
+    static std::string cache_key(const std::string& symbol, const indicator_spec& spec);
+    void evict_locked(const node* keep);
+
+    mutable std::mutex mutex_;
+    std::size_t capacity_ = 64u << 20;
+    std::size_t bytes_ = 0;
+    std::list<node> lru_; // most recently used first
+    std::unordered_map<std::string, std::list<node>::iterator> index_;
+};
+
+#endif // INDICATORS_HPP
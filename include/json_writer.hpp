@@ -0,0 +1,178 @@
+// json_writer.hpp
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <nlohmann/json.hpp>
+
+// Formats a double the way nlohmann::json::dump() does: fixed notation for
+// 1e-4 <= |value| < 1e15 (and zero) with a trailing ".0" for integral values,
+// scientific notation otherwise, and null for NaN/Inf. Digits are the
+// shortest that round-trip; dump()'s Grisu2 may end a 16-17 digit value one
+// digit differently, naming the same double.
+inline void append_json_number(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    const double magnitude = std::fabs(value);
+    const bool fixed = magnitude == 0.0 || (magnitude >= 1e-4 && magnitude < 1e15);
+    char buf[32];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value,
+                                   fixed ? std::chars_format::fixed : std::chars_format::scientific);
+    std::string_view digits(buf, static_cast<std::size_t>(end - buf));
+    out += digits;
+    if (fixed && digits.find('.') == std::string_view::npos) {
+        out += ".0";
+    }
+}
+
+template <class Int, std::enable_if_t<std::is_integral_v<Int>, int> = 0>
+inline void append_json_number(std::string& out, Int value) {
+    char buf[24];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, static_cast<std::size_t>(end - buf));
+}
+
+// Appends s as a quoted JSON string, escaping like nlohmann::json::dump()
+inline void append_json_string(std::string& out, std::string_view s) {
+    static constexpr char hex[] = "0123456789abcdef";
+    out += '"';
+    std::size_t run = 0;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+                break;
+        }
+    }
+    out.append(s.data() + run, s.size() - run);
+    out += '"';
+}
+
+// Streaming JSON writer that appends compact JSON to a caller-owned string.
+// No DOM is built; separators are tracked per nesting level. Keys must be
+// written in the order the output should have them.
+class json_writer {
+public:
+    explicit json_writer(std::string& out) noexcept : out_(out) {}
+
+    std::string& buffer() noexcept { return out_; }
+
+    json_writer& begin_object() { open('{'); return *this; }
+    json_writer& end_object() { close('}'); return *this; }
+    json_writer& begin_array() { open('['); return *this; }
+    json_writer& end_array() { close(']'); return *this; }
+
+    json_writer& key(std::string_view name) {
+        separator();
+        append_json_string(out_, name);
+        out_ += ':';
+        after_key_ = true;
+        return *this;
+    }
+
+    json_writer& null() { separator(); out_ += "null"; return *this; }
+    json_writer& value(bool b) { separator(); out_ += b ? "true" : "false"; return *this; }
+    json_writer& value(double d) { separator(); append_json_number(out_, d); return *this; }
+    json_writer& value(std::string_view s) { separator(); append_json_string(out_, s); return *this; }
+    json_writer& value(const char* s) { return value(std::string_view(s)); }
+    json_writer& value(const std::string& s) { return value(std::string_view(s)); }
+
+    template <class Int, std::enable_if_t<std::is_integral_v<Int> && !std::is_same_v<Int, bool>, int> = 0>
+    json_writer& value(Int i) { separator(); append_json_number(out_, i); return *this; }
+
+    // Writes an existing DOM value in place, without an intermediate dump()
+    json_writer& value(const nlohmann::json& j) {
+        using value_t = nlohmann::json::value_t;
+        switch (j.type()) {
+            case value_t::object:
+                begin_object();
+                for (auto it = j.begin(); it != j.end(); ++it) {
+                    key(it.key());
+                    value(it.value());
+                }
+                return end_object();
+            case value_t::array:
+                begin_array();
+                for (const auto& v : j) {
+                    value(v);
+                }
+                return end_array();
+            case value_t::string:
+                return value(std::string_view(j.get_ref<const std::string&>()));
+            case value_t::boolean:
+                return value(j.get<bool>());
+            case value_t::number_integer:
+                return value(j.get<std::int64_t>());
+            case value_t::number_unsigned:
+                return value(j.get<std::uint64_t>());
+            case value_t::number_float:
+                return value(j.get<double>());
+            case value_t::binary:
+            case value_t::discarded:
+            case value_t::null:
+                break;
+        }
+        return null();
+    }
+
+private:
+    void separator() {
+        if (after_key_) {
+            after_key_ = false;
+            return;
+        }
+        if (depth_ > 0) {
+            if (has_items_ & (std::uint64_t{1} << (depth_ - 1))) {
+                out_ += ',';
+            }
+            has_items_ |= std::uint64_t{1} << (depth_ - 1);
+        }
+    }
+
+    void open(char c) {
+        if (depth_ == max_depth) {
+            throw std::length_error("json_writer: nesting deeper than 64 levels");
+        }
+        separator();
+        out_ += c;
+        ++depth_;
+        has_items_ &= ~(std::uint64_t{1} << (depth_ - 1));
+    }
+
+    void close(char c) {
+        out_ += c;
+        --depth_;
+    }
+
+    static constexpr unsigned max_depth = 64;
+
+    std::string& out_;
+    std::uint64_t has_items_ = 0;
+    unsigned depth_ = 0;
+    bool after_key_ = false;
+};
+
+#endif // JSON_WRITER_HPP
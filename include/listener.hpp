@@ -11,12 +11,19 @@
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
 
-// Accepts incoming connections and launches the sessions
+// Accepts incoming connections and launches the sessions, each on a strand.
+//
+// With per_core set, the listener is one of several, each owning an
+// io_context run by a single thread: the acceptor sets SO_REUSEPORT so all of
+// them bind the same port and the kernel spreads connections among them, and
+// sessions never leave the thread that accepted them. Those sessions run on
+// the io_context's executor directly (core_session), without a strand.
 class listener : public std::enable_shared_from_this<listener> {
     net::io_context& ioc_;
     tcp::acceptor acceptor_;
     std::shared_ptr<std::string const> doc_root_;
     std::shared_ptr<IDatabase> db_;
+    bool per_core_;
 public:
     //listener(
     //    net::io_context& ioc,
@@ -27,13 +34,15 @@ public:
         net::io_context& ioc,
         tcp::endpoint endpoint,
         std::shared_ptr<std::string const> const& doc_root,
-        std::shared_ptr<IDatabase> db);
+        std::shared_ptr<IDatabase> db,
+        bool per_core = false);
 
     void run();
 
 private:
     void do_accept();
-    void on_accept(beast::error_code ec, tcp::socket socket);
+    template <class Session>
+    void on_accept(beast::error_code ec, typename Session::socket_type socket);
 };
 
 #endif
\ No newline at end of file
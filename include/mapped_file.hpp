@@ -0,0 +1,39 @@
+// mapped_file.hpp
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. The mapping is released when the
+// object is destroyed, so any string_view handed out by view() must not
+// outlive it.
+class mapped_file {
+public:
+    // Read-ahead hint passed to madvise()
+    enum class access_hint { sequential, normal };
+
+    explicit mapped_file(const std::string& path, access_hint hint = access_hint::sequential);
+    ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+
+    const char* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    std::string_view view() const noexcept { return {data_, size_}; }
+    const std::string& path() const noexcept { return path_; }
+
+private:
+    void release() noexcept;
+
+    std::string path_;
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+#endif // MAPPED_FILE_HPP
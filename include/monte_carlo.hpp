@@ -0,0 +1,91 @@
+// monte_carlo.hpp
+#ifndef MONTE_CARLO_HPP
+#define MONTE_CARLO_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "json_writer.hpp"
+#include "price_series.hpp"
+#include "series_query.hpp"
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3"): a counter-based generator. Every output block is a pure function of
+// (key, counter), so any path can be generated on any thread in any order
+// and the stream never depends on how work was split.
+struct philox4x32 {
+    using block = std::array<std::uint32_t, 4>;
+
+    static block generate(std::uint64_t key, block counter) noexcept {
+        std::uint32_t k0 = static_cast<std::uint32_t>(key);
+        std::uint32_t k1 = static_cast<std::uint32_t>(key >> 32);
+        for (int round = 0; round < 10; ++round) {
+            const std::uint64_t p0 = std::uint64_t{0xD2511F53} * counter[0];
+            const std::uint64_t p1 = std::uint64_t{0xCD9E8D57} * counter[2];
+            counter = {static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ k0,
+                       static_cast<std::uint32_t>(p1),
+                       static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ k1,
+                       static_cast<std::uint32_t>(p0)};
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        return counter;
+    }
+};
+
+// bootstrap: each day's return is drawn, with replacement, from the
+// historical daily returns. gbm: geometric Brownian motion with the drift
+// and volatility of the historical log returns.
+enum class simulation_method { bootstrap, gbm };
+
+// Throws std::invalid_argument for an unknown name
+simulation_method parse_simulation_method(std::string_view name);
+const char* simulation_method_name(simulation_method method) noexcept;
+
+// Limits per request: stored results are 8 bytes per path
+constexpr std::size_t simulate_max_paths = 5000000;
+constexpr std::size_t simulate_max_horizon = 2520;
+constexpr std::uint64_t simulate_max_steps = 2000000000; // paths x horizon
+
+struct simulation_request {
+    simulation_method method = simulation_method::bootstrap;
+    std::size_t paths = 100000;
+    std::size_t horizon = 252; // trading days
+    std::uint64_t seed = 1;
+};
+
+// Quantiles of a simulated quantity over all paths
+struct simulation_quantiles {
+    double mean = 0.0;
+    double p5 = 0.0;
+    double p25 = 0.0;
+    double p50 = 0.0;
+    double p75 = 0.0;
+    double p95 = 0.0;
+};
+
+struct simulation_result {
+    std::size_t history_returns = 0;
+    std::int32_t history_first_day = 0;
+    std::int32_t history_last_day = 0;
+    double daily_drift = 0.0;      // mean historical log return
+    double daily_volatility = 0.0; // stddev of historical log returns
+    simulation_quantiles terminal; // value of 1.0 invested, after horizon days
+    simulation_quantiles max_drawdown;
+    double probability_of_loss = 0.0;
+};
+
+// Simulates request.paths paths of request.horizon days from the daily
+// returns of range, spread over the compute pool. Path i draws only from
+// philox4x32 counters tagged with i, so the result for a given seed is the
+// same for any thread count. Throws std::invalid_argument when range has
+// fewer than two rows or a limit is exceeded.
+simulation_result run_simulation(const price_series& series, row_range range, const simulation_request& request);
+
+// Writes the result as one JSON object with sorted keys
+void write_simulation_result(json_writer& writer, std::string_view symbol, const simulation_request& request,
+                             const simulation_result& result);
+
+#endif // MONTE_CARLO_HPP
@@ -0,0 +1,76 @@
+// portfolio_backtest.hpp
+#ifndef PORTFOLIO_BACKTEST_HPP
+#define PORTFOLIO_BACKTEST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_writer.hpp"
+#include "price_series.hpp"
+
+// How often holdings are reset to the target weights. Between rebalances
+// each position drifts with its own price. A period rebalances on the first
+// common trading day of each new week/month/quarter/year.
+enum class rebalance_period { none, daily, weekly, monthly, quarterly, yearly };
+
+// Throws std::invalid_argument for an unknown name
+rebalance_period parse_rebalance_period(std::string_view name);
+const char* rebalance_period_name(rebalance_period period) noexcept;
+
+// Most weight vectors one batch may evaluate
+constexpr std::size_t backtest_max_batch = 100000;
+
+struct backtest_summary {
+    double total_return = 0.0;
+    double cagr = 0.0;              // over trading_days_per_year trading days
+    double volatility = 0.0;        // annualized stddev of daily returns
+    double sharpe = 0.0;            // annualized; NaN when volatility is 0
+    double max_drawdown = 0.0;      // negative fraction of the peak
+};
+
+// Daily price growth of a basket of symbols on the dates they all share,
+// prepared once and then shared by every weight vector run against it.
+// Growth is stored day-major so one day's update touches one contiguous row.
+class backtest_universe {
+public:
+    // Throws std::invalid_argument when fewer than two common dates exist
+    backtest_universe(const std::vector<std::shared_ptr<const price_series>>& series,
+                      std::optional<std::int32_t> from,
+                      std::optional<std::int32_t> to,
+                      rebalance_period period);
+
+    std::size_t symbols() const noexcept { return symbols_.size(); }
+    const std::vector<std::string>& symbol_names() const noexcept { return symbols_; }
+    const std::vector<std::int32_t>& days() const noexcept { return days_; }
+    rebalance_period period() const noexcept { return period_; }
+
+    // Normalizes weights (one per symbol) to sum to 1. Throws
+    // std::invalid_argument for a wrong count, a non-finite or negative
+    // weight, or a zero total.
+    std::vector<double> normalize(const std::vector<double>& weights) const;
+
+    // Runs normalized weights from 1.0 of capital. When equity is given it
+    // receives the portfolio value on each of days().
+    backtest_summary run(const double* weights, double risk_free, std::vector<double>* equity = nullptr) const;
+
+    // Runs weights (count vectors of symbols() normalized weights, back to
+    // back) in parallel on the compute pool
+    std::vector<backtest_summary> run_batch(const std::vector<double>& weights, std::size_t count,
+                                            double risk_free) const;
+
+private:
+    std::vector<std::string> symbols_;
+    std::vector<std::int32_t> days_;
+    std::vector<double> growth_;          // (days - 1) x symbols: price[d + 1] / price[d]
+    std::vector<std::uint8_t> rebalance_; // per growth row: reset to targets after it
+    rebalance_period period_;
+};
+
+// Writes {"cagr":..,"max_drawdown":..,"sharpe":..,"total_return":..,"volatility":..}
+void write_backtest_summary(json_writer& writer, const backtest_summary& summary);
+
+#endif // PORTFOLIO_BACKTEST_HPP
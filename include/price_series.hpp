@@ -0,0 +1,127 @@
+// price_series.hpp
+#ifndef PRICE_SERIES_HPP
+#define PRICE_SERIES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "StockPrice.hpp"
+#include "csv_schema.hpp"
+#include "series_column.hpp"
+
+class range_index;
+class series_pyramid;
+class return_sketches;
+
+// Parses an abbreviated volume such as "8.17M" or "335.56K"; empty is NaN
+double parse_volume(std::string_view text);
+
+// One parsed row of a price CSV, already in the numeric form of the columns
+struct price_record {
+    std::int32_t day;
+    double price;
+    double open;
+    double high;
+    double low;
+    double volume;
+    double change_percent;
+};
+
+// "dd/mm/yyyy" -> day number
+struct csv_day {
+    static void parse(std::string_view field, std::int32_t& out);
+};
+
+// "8.17M" -> 8170000
+struct csv_volume {
+    static void parse(std::string_view field, double& out) { out = parse_volume(field); }
+};
+
+template <>
+struct csv_schema<price_record> {
+    static constexpr auto columns = std::make_tuple(
+        csv_bind<csv_day>("Date", &price_record::day),
+        csv_bind("Price", &price_record::price),
+        csv_bind("Open", &price_record::open),
+        csv_bind("High", &price_record::high),
+        csv_bind("Low", &price_record::low),
+        csv_bind<csv_volume>("Vol.", &price_record::volume),
+        csv_bind<csv_percent>("Change %", &price_record::change_percent));
+};
+
+// Daily price history of one symbol in struct-of-arrays layout. Rows are
+// sorted by ascending day number; all columns have the same length.
+// A missing volume is stored as NaN. Columns loaded from a snapshot borrow
+// the mapped file instead of owning a copy (see series_snapshot.hpp).
+struct price_series {
+    std::string symbol;
+    series_column<std::int32_t> day;
+    series_column<double> price;
+    series_column<double> open;
+    series_column<double> high;
+    series_column<double> low;
+    series_column<double> volume;
+    series_column<double> change_percent;
+
+    // Derived structures attached by symbol_store (see range_index.hpp,
+    // series_pyramid.hpp and return_sketches.hpp). Null for series that were
+    // not loaded through the store, and briefly for mapped snapshots while
+    // they are built.
+    std::shared_ptr<const range_index> index;
+    std::shared_ptr<const series_pyramid> pyramid;
+    std::shared_ptr<const return_sketches> sketches;
+
+    // Set by symbol_store: versions that only appended rows keep the lineage
+    // of the version they extend, so values derived from its rows stay
+    // valid; a reload or an out-of-order insert starts a new one. 0 outside
+    // the store.
+    std::uint64_t lineage = 0;
+
+    std::size_t size() const noexcept { return day.size(); }
+    bool empty() const noexcept { return day.empty(); }
+
+    void reserve(std::size_t rows);
+    void push_back(const price_record& record);
+
+    // Rebuilds the row-oriented view of row i in the original CSV formatting
+    StockPrice row(std::size_t i) const;
+
+    // Approximate heap footprint of the owned columns
+    std::size_t memory_bytes() const noexcept;
+};
+
+// Formats a volume back to the abbreviated form; NaN is the empty string
+std::string format_volume(double volume);
+
+// How much of a CSV a series reflects, and a fingerprint of those bytes
+struct csv_extent {
+    std::size_t bytes = 0;         // parsed so far
+    std::size_t lines = 0;         // end of the last complete line parsed; appends start here
+    std::uint64_t fingerprint = 0; // csv_fingerprint of the file at bytes
+};
+
+// Hashes the header line of a CSV and the tail of its first bytes bytes, the
+// part a new row or a replaced export changes. Appends after bytes are only
+// valid while this still matches what was recorded when they were parsed.
+std::uint64_t csv_fingerprint(std::string_view file, std::size_t bytes);
+
+// The extent of the first bytes bytes of file. A last line without its
+// newline counts as parsed but not complete: text written after it may
+// continue that line rather than start a new row.
+csv_extent csv_extent_of(std::string_view file, std::size_t bytes);
+
+// Loads a price CSV (Date, Price, Open, High, Low, Vol., Change %) into
+// columns. When extent is given it receives the extent of the file that was
+// parsed.
+price_series load_price_series(const std::string& symbol, const std::string& file_path,
+                               csv_extent* extent = nullptr);
+
+// Parses records (whole lines that follow a CSV with the given header) and
+// adds them to s, keeping the rows sorted by day. Returns the rows added.
+std::size_t append_price_rows(price_series& s, const std::vector<std::string_view>& header,
+                              std::string_view records, const std::string& file_path);
+
+#endif // PRICE_SERIES_HPP
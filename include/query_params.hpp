@@ -0,0 +1,118 @@
+// query_params.hpp
+#ifndef QUERY_PARAMS_HPP
+#define QUERY_PARAMS_HPP
+
+#include <charconv>
+#include <cmath>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Splits a request-target into its path and query string (without the '?')
+inline std::pair<std::string_view, std::string_view> split_target(std::string_view target) {
+    auto pos = target.find('?');
+    if (pos == std::string_view::npos) {
+        return {target, {}};
+    }
+    return {target.substr(0, pos), target.substr(pos + 1)};
+}
+
+// Decodes %XX escapes and '+' in a query component, appending to out
+template <class String>
+void url_decode_append(std::string_view in, String& out) {
+    auto hex = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    out.reserve(out.size() + in.size());
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        if (in[i] == '+') {
+            out.push_back(' ');
+        } else if (in[i] == '%' && i + 2 < in.size() && hex(in[i + 1]) >= 0 && hex(in[i + 2]) >= 0) {
+            out.push_back(static_cast<char>(hex(in[i + 1]) * 16 + hex(in[i + 2])));
+            i += 2;
+        } else {
+            out.push_back(in[i]);
+        }
+    }
+}
+
+// Decodes %XX escapes and '+' in a query component
+inline std::string url_decode(std::string_view in) {
+    std::string out;
+    url_decode_append(in, out);
+    return out;
+}
+
+// Parsed "a=1&b=2" query string. Lookups return the first occurrence.
+class query_params {
+public:
+    query_params() = default;
+
+    // The decoded names and values are allocated from resource, typically
+    // the request's arena (see request_arena.hpp)
+    explicit query_params(std::string_view query,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : params_(resource)
+    {
+        while (!query.empty()) {
+            auto amp = query.find('&');
+            std::string_view pair = query.substr(0, amp);
+            query = amp == std::string_view::npos ? std::string_view{} : query.substr(amp + 1);
+            if (pair.empty()) {
+                continue;
+            }
+            auto eq = pair.find('=');
+            std::pmr::string name(resource);
+            std::pmr::string value(resource);
+            url_decode_append(pair.substr(0, eq), name);
+            if (eq != std::string_view::npos) {
+                url_decode_append(pair.substr(eq + 1), value);
+            }
+            params_.emplace_back(std::move(name), std::move(value));
+        }
+    }
+
+    std::optional<std::string_view> get(std::string_view key) const {
+        for (const auto& [name, value] : params_) {
+            if (name == key) {
+                return std::string_view(value);
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool has(std::string_view key) const { return get(key).has_value(); }
+    bool empty() const noexcept { return params_.empty(); }
+
+private:
+    std::pmr::vector<std::pair<std::pmr::string, std::pmr::string>> params_;
+};
+
+// Parses a positive integer query value; throws std::invalid_argument
+inline std::size_t parse_count_param(std::string_view name, std::string_view text) {
+    std::size_t value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size() || value == 0) {
+        throw std::invalid_argument("Invalid " + std::string(name) + ": '" + std::string(text) + "'");
+    }
+    return value;
+}
+
+// Parses a finite decimal query value; throws std::invalid_argument
+inline double parse_number_param(std::string_view name, std::string_view text) {
+    double value = 0.0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size() || !std::isfinite(value)) {
+        throw std::invalid_argument("Invalid " + std::string(name) + ": '" + std::string(text) + "'");
+    }
+    return value;
+}
+
+#endif // QUERY_PARAMS_HPP
@@ -0,0 +1,79 @@
+// range_index.hpp
+#ifndef RANGE_INDEX_HPP
+#define RANGE_INDEX_HPP
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "json_writer.hpp"
+#include "price_series.hpp"
+#include "series_query.hpp"
+
+// Aggregates of one column over a row range. min/max/mean/variance are NaN
+// for an empty range; variance is the sample variance (NaN below two rows).
+struct range_aggregate {
+    std::size_t count = 0;
+    double sum = 0.0;
+    double mean = 0.0;
+    double variance = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// Per-column index answering min/max/sum/mean/variance over any row range in
+// constant time, built once per published series version.
+//
+//  - sum, mean, variance: prefix sums of (x - c) and (x - c)^2, where c is the
+//    column mean; shifting keeps the variance of short windows accurate on
+//    high-priced series.
+//  - min, max: a sparse table over blocks of 32 rows, so memory is
+//    O(n/32 log n) rather than O(n log n). A query combines two table lookups
+//    with scans of at most two partial blocks.
+//
+// The index refers to the columns of the series it was built from; pass that
+// same series to aggregate().
+class range_index {
+public:
+    // Columns that are indexed; Volume is not, since missing volumes are NaN
+    static constexpr unsigned indexed_fields =
+        field_price | field_open | field_high | field_low | field_change_percent;
+
+    explicit range_index(const price_series& series);
+
+    range_aggregate aggregate(const price_series& series, series_field column, row_range range) const;
+
+    std::size_t memory_bytes() const noexcept;
+
+    // The column a field bit names, or nullptr for Date/Volume
+    static const series_column<double>* column_of(const price_series& series, series_field column) noexcept;
+
+private:
+    static constexpr std::size_t block_size = 32;
+
+    struct column_index {
+        double shift = 0.0;
+        std::vector<double> sum;    // sum[i] = sum of (x - shift) over rows [0, i)
+        std::vector<double> sum_sq; // same for (x - shift)^2
+        std::vector<std::vector<double>> min_table; // [k][b] = min over blocks [b, b + 2^k)
+        std::vector<std::vector<double>> max_table;
+    };
+
+    static int slot_of(series_field column) noexcept;
+    static void build(column_index& index, const series_column<double>& values);
+
+    std::array<column_index, 5> columns_;
+};
+
+// Linear-time aggregate of one column, for series without an index
+range_aggregate scan_range_aggregate(const series_column<double>& values, row_range range);
+
+// Aggregates column over range through series.index when it is built, by a
+// scan otherwise. Throws std::invalid_argument for a column that is not in
+// range_index::indexed_fields.
+range_aggregate aggregate_range(const price_series& series, series_field column, row_range range);
+
+// Writes {"count":..,"max":..,"mean":..,"min":..,"stddev":..,"sum":..,"variance":..}
+void write_range_aggregate(json_writer& writer, const range_aggregate& aggregate);
+
+#endif // RANGE_INDEX_HPP
@@ -0,0 +1,77 @@
+// request_arena.hpp
+#ifndef REQUEST_ARENA_HPP
+#define REQUEST_ARENA_HPP
+
+#include <boost/beast/http/fields.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+
+// Monotonic memory for everything one request allocates before its response
+// is written: header fields, the body, parsed query parameters and the queued
+// response entry. Allocation bumps a pointer in a block the arena keeps for
+// the life of the connection, deallocation is a no-op and reset() rewinds the
+// block. A request that outgrows the block spills to the heap; on reset the
+// block is regrown to the high-water mark, so once a connection has seen its
+// typical request the steady state allocates nothing from the global heap.
+class request_arena final : public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t initial_bytes = 8 * 1024;
+    // Larger blocks are not kept between requests
+    static constexpr std::size_t max_block_bytes = 1024 * 1024;
+
+    explicit request_arena(std::size_t bytes = initial_bytes);
+    ~request_arena() override;
+
+    request_arena(const request_arena&) = delete;
+    request_arena& operator=(const request_arena&) = delete;
+
+    // Frees the spilled allocations and rewinds the block. Everything
+    // allocated since the last reset must be dead.
+    void reset();
+
+    std::size_t capacity() const noexcept { return capacity_; }
+    // Bytes handed out since the last reset, block and spill
+    std::size_t used() const noexcept { return used_ + spilled_bytes_; }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    struct spill;
+
+    void release_spills();
+
+    std::unique_ptr<std::byte[]> block_;
+    std::size_t capacity_ = 0;
+    std::size_t used_ = 0;
+    spill* spilled_ = nullptr;
+    std::size_t spilled_bytes_ = 0;
+};
+
+// Request types whose fields and body live in a request_arena
+using arena_allocator = std::pmr::polymorphic_allocator<char>;
+using arena_fields = boost::beast::http::basic_fields<arena_allocator>;
+using arena_string_body = boost::beast::http::basic_string_body<char, std::char_traits<char>, arena_allocator>;
+using arena_request = boost::beast::http::request<arena_string_body, arena_fields>;
+
+// Resource for a handler's scratch allocations: the request's arena when its
+// fields were allocated from one, otherwise the default resource
+template <class Body, class Allocator>
+std::pmr::memory_resource* request_resource(
+    const boost::beast::http::request<Body, boost::beast::http::basic_fields<Allocator>>& req)
+{
+    if constexpr (std::is_same_v<Allocator, arena_allocator>) {
+        return req.get_allocator().resource();
+    } else {
+        return std::pmr::get_default_resource();
+    }
+}
+
+#endif // REQUEST_ARENA_HPP
@@ -0,0 +1,128 @@
+// request_coalescer.hpp
+#ifndef REQUEST_COALESCER_HPP
+#define REQUEST_COALESCER_HPP
+
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include "CustomFormatter.hpp"
+#include "request_utils.hpp"
+#include "shared_body.hpp"
+#include "single_flight.hpp"
+
+// A response produced once and sent to every request coalesced onto it. The
+// per-connection parts (HTTP version, keep-alive) are filled in per request.
+struct coalesced_response {
+    boost::beast::http::status status = boost::beast::http::status::ok;
+    std::string content_type = "application/json";
+    std::vector<std::pair<std::string, std::string>> fields; // extra headers
+    std::string body;
+};
+
+// Process-wide single_flight groups for response bodies, one per route
+// ("/db", "/loadcsv", ...). Identical requests that arrive on any io thread
+// while one of them is being computed send its bytes once it is done, without
+// holding up their thread meanwhile.
+class request_coalescer {
+public:
+    static request_coalescer& getInstance() {
+        static request_coalescer instance;
+        return instance;
+    }
+
+    request_coalescer(const request_coalescer&) = delete;
+    request_coalescer& operator=(const request_coalescer&) = delete;
+
+    // Runs compute() (returning a coalesced_response) for key in route's
+    // group and returns the result, unless an identical call is already
+    // running; then returns nothing and that call hands its result to wait
+    // (see single_flight::run)
+    std::optional<single_flight<coalesced_response>::result> run(
+        const std::string& route, const std::string& key,
+        const std::function<coalesced_response()>& compute,
+        single_flight<coalesced_response>::waiter wait);
+
+    // Counters of every route used so far, by route name
+    std::vector<std::pair<std::string, single_flight_stats>> stats() const;
+
+private:
+    request_coalescer() = default;
+
+    single_flight<coalesced_response>& group(const std::string& route);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<single_flight<coalesced_response>>> routes_;
+};
+
+// Response for req carrying shared's bytes; coalesced responses are marked
+// with an X-Coalesced header
+template <class Body, class Allocator>
+boost::beast::http::response<shared_body> make_coalesced_response(
+    const boost::beast::http::request<Body, boost::beast::http::basic_fields<Allocator>>& req,
+    const single_flight<coalesced_response>::result& shared)
+{
+    namespace http = boost::beast::http;
+    http::response<shared_body> res{shared.value->status, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, shared.value->content_type);
+    for (const auto& [name, value] : shared.value->fields) {
+        res.set(name, value);
+    }
+    if (shared.coalesced) {
+        res.set("X-Coalesced", "1");
+    }
+    res.keep_alive(req.keep_alive());
+    res.body() = std::shared_ptr<const std::string>(shared.value, &shared.value->body);
+    res.prepare_payload();
+    return res;
+}
+
+// Sends req the response compute() makes, coalesced with identical requests
+// in route's group under key. A request that joins one already running is
+// deferred (see response_queue::defer) rather than waited for on this
+// thread; it is sent that one's bytes, or a 500 if it threw, when it is
+// done. An exception from compute() reaches the caller that ran it.
+template <class Body, class Allocator, class Send>
+void send_coalesced(
+    const std::string& route, const std::string& key,
+    const boost::beast::http::request<Body, boost::beast::http::basic_fields<Allocator>>& req,
+    Send& send, const std::function<coalesced_response()>& compute)
+{
+    namespace http = boost::beast::http;
+    auto shared = request_coalescer::getInstance().run(
+        route, key, compute,
+        [route, version = req.version(), keep_alive = req.keep_alive(), later = send.defer()](auto shared) {
+            later([route, version, keep_alive, shared = std::move(shared)](auto& send) {
+                // The request itself is gone; its response needs only these
+                http::request<http::empty_body> head{http::verb::get, "", version};
+                head.keep_alive(keep_alive);
+                if (shared.error) {
+                    std::string what = "Unknown error";
+                    try {
+                        std::rethrow_exception(shared.error);
+                    } catch (const std::exception& e) {
+                        what = e.what();
+                    } catch (...) {
+                    }
+                    return send(server_error(head, what));
+                }
+                spdlog::info("{} response sent (coalesced)", route);
+                send(make_coalesced_response(head, shared));
+            });
+        });
+    if (shared) {
+        spdlog::info("{} response sent", route);
+        send(make_coalesced_response(req, *shared));
+    }
+}
+
+#endif // REQUEST_COALESCER_HPP
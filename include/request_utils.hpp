@@ -16,15 +16,13 @@ auto bad_request(const http::request<Body, http::basic_fields<Allocator>> &req,
     spdlog::warn("Bad request: {}", why);
 
     StandardResponse res_struct = create_error_response(400, std::string(why), "Bad Request");
-    json res_json = res_struct.to_json();
-    std::string response_body = res_json.dump();
 
     http::response<http::string_body> res{
         http::status::bad_request, req.version()};
     res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
     res.set(http::field::content_type, "application/json");
     res.keep_alive(req.keep_alive());
-    res.body() = response_body;
+    res_struct.write_json(res.body());
     res.prepare_payload();
     return res;
 }
@@ -37,15 +35,13 @@ auto not_found(const http::request<Body, http::basic_fields<Allocator>> &req, be
     spdlog::warn("Resource not found: {}", target);
 
     StandardResponse res_struct = create_not_found_response(std::string(target));
-    json res_json = res_struct.to_json();
-    std::string response_body = res_json.dump();
 
     http::response<http::string_body> res{
         http::status::not_found, req.version()};
     res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
     res.set(http::field::content_type, "application/json");
     res.keep_alive(req.keep_alive());
-    res.body() = response_body;
+    res_struct.write_json(res.body());
     res.prepare_payload();
     return res;
 }
@@ -57,15 +53,36 @@ auto server_error(const http::request<Body, http::basic_fields<Allocator>> &req,
     spdlog::error("Server error: {}", what);
 
     StandardResponse res_struct = create_internal_server_error_response(std::string(what));
-    json res_json = res_struct.to_json();
-    std::string response_body = res_json.dump();
 
     http::response<http::string_body> res{
         http::status::internal_server_error, req.version()};
     res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
     res.set(http::field::content_type, "application/json");
     res.keep_alive(req.keep_alive());
-    res.body() = response_body;
+    res_struct.write_json(res.body());
+    res.prepare_payload();
+    return res;
+}
+
+// Helper function to create standardized method not allowed responses;
+// allow is the Allow header value, e.g. "GET, POST"
+template <class Body, class Allocator>
+auto method_not_allowed(const http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view allow)
+{
+    spdlog::warn("Method not allowed: {} (allowed: {})",
+                 std::string_view(req.method_string().data(), req.method_string().size()),
+                 std::string_view(allow.data(), allow.size()));
+
+    StandardResponse res_struct = create_error_response(
+        405, "Method " + std::string(req.method_string()) + " is not allowed for this resource.", "Method Not Allowed");
+
+    http::response<http::string_body> res{
+        http::status::method_not_allowed, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, "application/json");
+    res.set(http::field::allow, allow);
+    res.keep_alive(req.keep_alive());
+    res_struct.write_json(res.body());
     res.prepare_payload();
     return res;
 }
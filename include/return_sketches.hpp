@@ -0,0 +1,54 @@
+// return_sketches.hpp
+#ifndef RETURN_SKETCHES_HPP
+#define RETURN_SKETCHES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "price_series.hpp"
+#include "series_query.hpp"
+#include "tdigest.hpp"
+
+// t-digests of a series' daily ChangePercent, one per calendar year, with
+// the years paired up level by level into sketches of 2, 4, 8... years (a
+// segment tree). A window's distribution is the merge of the O(log years)
+// tree sketches that tile the years it covers whole, plus the exact values
+// of the partial years at its ends, so a percentile query merges a few
+// thousand centroids instead of sorting every row. Missing (NaN) changes
+// are skipped.
+class return_sketches {
+public:
+    explicit return_sketches(const price_series& series);
+
+    // Sketches of series after rows from first_changed on were added. Years
+    // of previous (built from the earlier version) that end before that row
+    // are copied; only the later ones are rebuilt.
+    return_sketches(const price_series& series, const return_sketches& previous, std::size_t first_changed);
+
+    // Adds the changes of rows (of the series these sketches were built from) to out
+    void add_window(const price_series& series, row_range rows, tdigest& out) const;
+
+    std::size_t buckets() const noexcept { return buckets_.size(); }
+    std::size_t memory_bytes() const noexcept;
+
+private:
+    struct bucket {
+        std::uint32_t begin; // rows [begin, end) fall in one calendar year
+        std::uint32_t end;
+    };
+
+    // Builds the years from row first_row on, then every tree sketch from
+    // the ones already kept
+    void build(const price_series& series, std::size_t first_row);
+
+    std::vector<bucket> buckets_; // ascending
+    // levels_[l][i] covers years [i << l, (i + 1) << l); only whole pairs
+    // are merged upwards
+    std::vector<std::vector<tdigest>> levels_;
+};
+
+// Adds the ChangePercent values of rows to out: through series.sketches
+// when attached, otherwise value by value
+void add_change_percents(const price_series& series, row_range rows, tdigest& out);
+
+#endif // RETURN_SKETCHES_HPP
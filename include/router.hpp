@@ -0,0 +1,121 @@
+// router.hpp
+#ifndef ROUTER_HPP
+#define ROUTER_HPP
+
+#include <boost/beast/http.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Endpoints of the API, dispatched on by handle_request
+enum class route_id {
+    login,
+    hello,
+    db,
+    loadcsv,
+    connections,
+    coalescing,
+    symbols,
+    stats,
+    range,
+    correlation,
+    quantiles,
+    backtest,
+    backtest_batch,
+    simulate,
+    indicators,
+};
+
+// Authentication a route, or every path under a guarded prefix, requires
+enum class auth_policy {
+    none,
+    jwt,
+};
+
+// Set of HTTP methods, one bit per boost::beast::http::verb
+using method_set = std::uint64_t;
+
+constexpr method_set method_bit(boost::beast::http::verb method) {
+    return method_set{1} << static_cast<unsigned>(method);
+}
+
+// Maps request paths to routes through a radix trie built once at startup.
+//
+// A pattern is a path whose segments are literals or a {name} parameter
+// matching one non-empty segment, e.g. "/api/stats/{symbol}". Literal edges
+// are compressed and indexed by their first character, so a lookup costs one
+// comparison per edge on the path rather than one per registered route, and
+// literal edges are tried before a parameter. Several routes may share a
+// pattern with disjoint methods; a path that matches with no route for the
+// method is reported as method_not_allowed along with the methods it allows.
+//
+// Guards attach an auth_policy to a literal prefix so that paths under it
+// which match no route (and fall through to static files) still require it.
+//
+// find() does not allocate: parameters and the query are views into the
+// target passed in.
+class router {
+public:
+    static constexpr std::size_t max_params = 4;
+
+    enum class outcome {
+        matched,
+        method_not_allowed,
+        not_found,
+    };
+
+    struct match {
+        outcome result = outcome::not_found;
+        route_id id{};
+        auth_policy auth = auth_policy::none; // of the route, or of the guard above the path
+        method_set allow = 0;                 // methods of the path, when method_not_allowed
+        std::string_view path;
+        std::string_view query;               // without the '?'
+        std::array<std::string_view, max_params> params{};
+        std::size_t param_count = 0;
+
+        // Value of the named parameter of the matched route; empty if absent
+        std::string_view param(std::string_view name) const;
+
+    private:
+        friend class router;
+        const std::vector<std::string>* names_ = nullptr;
+    };
+
+    router();
+    ~router();
+
+    router(router&&) noexcept;
+    router& operator=(router&&) noexcept;
+
+    // Registers id for pattern and methods. Throws std::invalid_argument on a
+    // malformed pattern or a method already taken on that pattern.
+    void add(route_id id, std::string_view pattern, method_set methods, auth_policy auth);
+
+    // Requires auth for every path starting with prefix that no route matches
+    void guard(std::string_view prefix, auth_policy auth);
+
+    match find(boost::beast::http::verb method, std::string_view target) const;
+
+private:
+    struct node;
+    struct route;
+
+    node* insert_literal(node* at, std::string_view literal);
+    const node* find_node(const node* at, std::string_view rest, match& m) const;
+    auth_policy guard_for(std::string_view path) const;
+
+    std::unique_ptr<node> root_;
+};
+
+// The server's routes, built on first use
+const router& api_router();
+
+// "GET, POST" style list of methods for an Allow header
+std::string allow_header(method_set methods);
+
+#endif // ROUTER_HPP
@@ -0,0 +1,59 @@
+// series_column.hpp
+#ifndef SERIES_COLUMN_HPP
+#define SERIES_COLUMN_HPP
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// One column of a price_series. A column either owns its values in a vector
+// or borrows a read-only array from a longer-lived buffer (a mapped snapshot
+// file), which `owner` keeps alive. Readers see the same contiguous array
+// either way. Mutating a borrowed column first copies it into owned storage.
+template <class T>
+class series_column {
+public:
+    series_column() = default;
+
+    series_column(const T* data, std::size_t size, std::shared_ptr<const void> owner)
+        : view_(data), view_size_(size), owner_(std::move(owner))
+    {
+    }
+
+    const T* data() const noexcept { return owner_ ? view_ : owned_.data(); }
+    std::size_t size() const noexcept { return owner_ ? view_size_ : owned_.size(); }
+    bool empty() const noexcept { return size() == 0; }
+
+    const T& operator[](std::size_t i) const noexcept { return data()[i]; }
+    const T* begin() const noexcept { return data(); }
+    const T* end() const noexcept { return data() + size(); }
+
+    // True while the values live in someone else's buffer
+    bool borrowed() const noexcept { return owner_ != nullptr; }
+
+    // Heap bytes held by the column itself; borrowed values cost nothing here
+    std::size_t capacity_bytes() const noexcept { return owned_.capacity() * sizeof(T); }
+
+    void reserve(std::size_t n) { values().reserve(n); }
+    void push_back(const T& value) { values().push_back(value); }
+
+    // Owned storage for bulk edits; copies borrowed values on first use
+    std::vector<T>& values() {
+        if (owner_) {
+            owned_.assign(view_, view_ + view_size_);
+            view_ = nullptr;
+            view_size_ = 0;
+            owner_.reset();
+        }
+        return owned_;
+    }
+
+private:
+    std::vector<T> owned_;
+    const T* view_ = nullptr;
+    std::size_t view_size_ = 0;
+    std::shared_ptr<const void> owner_;
+};
+
+#endif // SERIES_COLUMN_HPP
@@ -0,0 +1,44 @@
+// series_correlation.hpp
+#ifndef SERIES_CORRELATION_HPP
+#define SERIES_CORRELATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "json_writer.hpp"
+#include "price_series.hpp"
+
+// Pairwise statistics of daily returns across symbols. The series are first
+// aligned on the dates they all have within [from, to]; returns are taken
+// between consecutive common dates, so a holiday in one market merges two
+// days of the others into one return.
+struct correlation_matrix {
+    std::vector<std::string> symbols;
+    std::size_t observations = 0; // returns per symbol
+    std::int32_t first_day = 0;
+    std::int32_t last_day = 0;
+    // symbols.size()^2, row-major. Sample covariance of the returns, and
+    // Pearson correlation (NaN for a symbol whose price never moved).
+    std::vector<double> covariance;
+    std::vector<double> correlation;
+};
+
+// Most symbols one request may compare
+constexpr std::size_t correlation_max_symbols = 512;
+
+// Aligns the series, then computes each aligned return column once and all
+// pairs from those columns in tiles on the compute pool. Throws
+// std::invalid_argument when fewer than two series are given or they share
+// fewer than three dates in the window.
+correlation_matrix compute_correlation_matrix(const std::vector<std::shared_ptr<const price_series>>& series,
+                                              std::optional<std::int32_t> from,
+                                              std::optional<std::int32_t> to);
+
+// Writes {"correlation":[[..]],"covariance":[[..]],"from":..,"observations":..,
+// "symbols":[..],"to":..}
+void write_correlation_matrix(json_writer& writer, const correlation_matrix& matrix);
+
+#endif // SERIES_CORRELATION_HPP
@@ -0,0 +1,58 @@
+// series_pyramid.hpp
+#ifndef SERIES_PYRAMID_HPP
+#define SERIES_PYRAMID_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "price_series.hpp"
+#include "series_query.hpp"
+
+// Chart resolutions, finest first. daily is the series itself.
+enum class series_resolution { daily, weekly, monthly };
+
+const char* series_resolution_name(series_resolution resolution) noexcept;
+
+// Weekly (Monday to Sunday) and monthly OHLC bars of a daily series, kept as
+// price_series so they serialize like daily rows. Each bar is dated by its
+// first trading day and holds:
+//   Open = first open, High = max high, Low = min low, Price = last close,
+//   Volume = sum of known volumes (NaN if none),
+//   ChangePercent = close-to-close change from the previous bar, 2 decimals.
+class series_pyramid {
+public:
+    explicit series_pyramid(const price_series& series);
+
+    // Pyramid of series after rows from first_changed on were added. Bars of
+    // previous (built from the earlier version) that end before that row are
+    // copied; only the tail is recomputed.
+    series_pyramid(const price_series& series, const series_pyramid& previous, std::size_t first_changed);
+
+    // Bars of a weekly or monthly level
+    const price_series& bars(series_resolution resolution) const;
+
+    // Bars that cover any of the daily rows in rows
+    row_range bars_covering(series_resolution resolution, row_range rows) const;
+
+    std::size_t memory_bytes() const noexcept;
+
+private:
+    struct level {
+        price_series bars;
+        std::vector<std::uint32_t> first_row; // daily row each bar starts at
+    };
+
+    static void build_level(level& out, series_resolution resolution, const price_series& series,
+                            std::size_t first_row);
+    const level& level_of(series_resolution resolution) const;
+
+    std::array<level, 2> levels_; // weekly, monthly
+};
+
+// Largest-triangle-three-buckets selection of at most points rows of range,
+// by Day against Price. Keeps the first and last row; the result is
+// ascending. Returns every row when the range already fits.
+std::vector<std::size_t> lttb_downsample(const price_series& series, row_range range, std::size_t points);
+
+#endif // SERIES_PYRAMID_HPP
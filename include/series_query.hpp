@@ -0,0 +1,80 @@
+// series_query.hpp
+#ifndef SERIES_QUERY_HPP
+#define SERIES_QUERY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_writer.hpp"
+#include "price_series.hpp"
+
+// Column selection for /loadcsv responses, one bit per StockPrice field
+enum series_field : unsigned {
+    field_date = 1u << 0,
+    field_price = 1u << 1,
+    field_open = 1u << 2,
+    field_high = 1u << 3,
+    field_low = 1u << 4,
+    field_volume = 1u << 5,
+    field_change_percent = 1u << 6,
+    field_all = (1u << 7) - 1
+};
+
+// Parses a comma-separated list of StockPrice field names (case-insensitive).
+// Date is always selected since it keys each row. Throws std::invalid_argument
+// on unknown names.
+unsigned parse_series_fields(std::string_view list);
+
+// Half-open row interval [begin, end) of a series
+struct row_range {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+
+    std::size_t size() const noexcept { return end - begin; }
+    bool empty() const noexcept { return begin >= end; }
+};
+
+// Rows whose day lies in [from, to]; either bound may be open. Binary search
+// over the sorted day column.
+row_range find_day_range(const price_series& series,
+                         std::optional<std::int32_t> from,
+                         std::optional<std::int32_t> to);
+
+// Dates present in every series within [from, to], ascending
+std::vector<std::int32_t> common_days(const std::vector<std::shared_ptr<const price_series>>& series,
+                                      std::optional<std::int32_t> from,
+                                      std::optional<std::int32_t> to);
+
+// Copies the closing price of each day in days (ascending, all present in
+// series, e.g. from common_days) to out
+void gather_prices(const price_series& series, const std::vector<std::int32_t>& days, double* out);
+
+// Writes row i as an object with the selected fields, using the StockPrice
+// key names in sorted order (as nlohmann::json would emit them)
+void write_series_row(json_writer& writer, const price_series& series, std::size_t i, unsigned fields);
+
+// Incremental serializer for a /loadcsv success response. Each call appends
+// the next piece (envelope prefix, one row, or the suffix) to out and returns
+// false once the document is complete. The output is byte-identical to
+// dumping the equivalent StandardResponse; rows are emitted newest first.
+class series_json_stream {
+public:
+    series_json_stream(std::shared_ptr<const price_series> series, row_range range, unsigned fields);
+
+    bool operator()(std::string& out);
+
+private:
+    enum class stage { prefix, rows, suffix, done };
+
+    std::shared_ptr<const price_series> series_;
+    row_range range_;
+    unsigned fields_;
+    std::size_t next_;
+    stage stage_ = stage::prefix;
+};
+
+#endif // SERIES_QUERY_HPP
@@ -0,0 +1,61 @@
+// series_snapshot.hpp
+#ifndef SERIES_SNAPSHOT_HPP
+#define SERIES_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "price_series.hpp"
+
+// Binary columnar snapshot of a price_series, written by the cap_snapshot
+// tool and memory-mapped by the server at startup.
+//
+// Layout (little-endian, native IEEE doubles):
+//   header     magic "CAPSNAP\0", format version, row count, the size and
+//              mtime of the CSV it was built from, a checksum, and one
+//              {id, element size, offset, bytes} entry per column
+//   columns    day (int32), price, open, high, low, volume, change_percent
+//              (double), each starting on a 64-byte boundary
+//
+// Opening a snapshot validates the header and the column bounds but does not
+// read the column data, so it costs the same for any dataset size. The
+// checksum (FNV-1a over the column bytes) is only computed when asked for.
+// Mapped pages are shared through the page cache by every process that opens
+// the same file.
+
+constexpr std::uint32_t series_snapshot_version = 1;
+
+// Header fields of a snapshot file
+struct snapshot_info {
+    std::uint32_t version = 0;
+    std::uint64_t rows = 0;
+    std::uint64_t file_size = 0;
+    std::uint64_t source_size = 0;      // bytes of the CSV the snapshot was built from
+    std::int64_t source_mtime_ns = 0;   // its modification time
+    std::uint64_t checksum = 0;
+    std::string symbol;
+};
+
+struct series_snapshot {
+    snapshot_info info;
+    price_series series;
+};
+
+// "<root>/<symbol>.capsnap"
+std::string snapshot_file_name(const std::string& root, std::string_view symbol);
+
+// Writes series to path (via a temporary file and rename, so readers never see
+// a partial snapshot). When source_path is given, its size and mtime are
+// recorded so a later open can tell whether the CSV has changed since.
+void write_series_snapshot(const price_series& series, const std::string& path,
+                           const std::string& source_path = {});
+
+// Maps a snapshot read-only. The returned series borrows the mapping, which
+// stays alive as long as any copy of its columns. Throws std::runtime_error on
+// a malformed file, a version mismatch, or (with verify_checksum) corruption.
+series_snapshot open_series_snapshot(const std::string& path, bool verify_checksum = false);
+
+// True when the CSV at source_path has the size and mtime recorded in info
+bool snapshot_matches_source(const snapshot_info& info, const std::string& source_path);
+
+#endif // SERIES_SNAPSHOT_HPP
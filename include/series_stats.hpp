@@ -0,0 +1,67 @@
+// series_stats.hpp
+#ifndef SERIES_STATS_HPP
+#define SERIES_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "json_writer.hpp"
+#include "price_series.hpp"
+#include "series_query.hpp"
+
+// Return and risk statistics over a row range of a price_series, computed by
+// vectorized kernels over the contiguous price column. The kernel set is
+// picked once from the running CPU (AVX2, else SSE2, else scalar); any lower
+// level can be requested explicitly for comparison. Levels differ only in
+// summation order, so results agree to rounding.
+
+enum class simd_level { scalar, sse2, avx2 };
+
+const char* simd_level_name(simd_level level) noexcept;
+
+// Widest kernel set the CPU and the build support
+simd_level best_simd_level() noexcept;
+
+// Trading days per year, used to annualize
+constexpr double trading_days_per_year = 252.0;
+
+struct series_stats {
+    std::size_t rows = 0;
+    std::int32_t first_day = 0;
+    std::int32_t last_day = 0;
+
+    // Simple daily returns price[i] / price[i - 1] - 1
+    double cumulative_return = 0.0;
+    double annualized_return = 0.0;
+    double mean_return = 0.0;
+    double stddev_return = 0.0;
+    double min_return = 0.0;
+    double max_return = 0.0;
+    double annualized_volatility = 0.0;
+
+    // Mean and standard deviation of the daily returns over a sliding window;
+    // the latest window and the extremes of the volatility. NaN when the
+    // range has fewer returns than the window.
+    std::size_t window = 0;
+    double rolling_mean = 0.0;
+    double rolling_volatility = 0.0;
+    double min_rolling_volatility = 0.0;
+    double max_rolling_volatility = 0.0;
+
+    // Deepest peak-to-trough decline, as a (negative) fraction of the peak
+    double max_drawdown = 0.0;
+    std::int32_t drawdown_peak_day = 0;
+    std::int32_t drawdown_trough_day = 0;
+
+    simd_level level = simd_level::scalar;
+};
+
+// Computes the statistics of range, which must hold at least two rows.
+// window must be at least 2. Throws std::invalid_argument otherwise.
+series_stats compute_series_stats(const price_series& series, row_range range, std::size_t window,
+                                  simd_level level = best_simd_level());
+
+// Writes stats as one JSON object with sorted keys
+void write_series_stats(json_writer& writer, std::string_view symbol, const series_stats& stats);
+
+#endif // SERIES_STATS_HPP
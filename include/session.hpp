@@ -3,12 +3,21 @@
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/strand.hpp>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
 #include <string>
 #include "handle_request.hpp"
 #include "utility.hpp"
 #include "IDatabase.hpp"
+#include "request_arena.hpp"
+#include "connection_pool.hpp"
 
 
 namespace beast = boost::beast;
@@ -17,53 +26,237 @@ namespace net = boost::asio;
 
 using tcp = net::ip::tcp;
 
-// Handles an HTTP server connection
-class session : public std::enable_shared_from_this<session> {
-    beast::tcp_stream stream_;
-    beast::flat_buffer buffer_;
-    std::shared_ptr<std::string const> doc_root_;
-    http::request<http::string_body> req_;
-    std::shared_ptr<void> res_;
-    std::shared_ptr<IDatabase> db_;
+// Executors of a connection, named as concrete types because an
+// any_io_executor holding a strand allocates on every copy, and the
+// completion of every read, write and timer copies one. With a shared
+// io_context run by several threads a connection needs a strand; in per_core
+// mode its io_context has a single thread, so its plain executor serializes
+// the handlers already and no strand is created per connection.
+using shared_session_executor = net::strand<net::io_context::executor_type>;
+using core_session_executor = net::io_context::executor_type;
+
+// Responses a session may have queued before it stops reading requests
+constexpr std::size_t session_pipeline_limit = 16;
+// Read buffer a session starts with, taken from the connection pool
+constexpr std::size_t session_buffer_bytes = 8 * 1024;
+
+// Handles an HTTP server connection.
+//
+// Requests are read and dispatched while earlier responses are still being
+// written, so HTTP/1.1 clients that pipeline requests on one connection do not
+// wait a round trip for each. Responses are written one at a time in request
+// order from a queue; once it holds session_pipeline_limit responses the
+// session stops reading until a write completes, which leaves further
+// requests in the socket buffers and pushes back on the client.
+//
+// Each request is parsed into a request_arena taken from the session's spare
+// ones; the handler's query parameters and the queued response entry come
+// from it too. The arena travels with the response and is reset and returned
+// once the response is written, so a connection reuses a few arenas instead
+// of calling the global allocator for every header and parameter.
+//
+// A handler that has to wait on work it does not run itself defers its
+// request through response_queue::defer instead of blocking the io thread.
+// The session then stops reading until the response is sent.
+//
+// Sessions are created with pool_allocator, and their read buffer, queue and
+// arenas come from the accepting thread's connection_pool, to which they
+// return when the connection closes.
+//
+// Executor is shared_session_executor or core_session_executor; session.cpp
+// instantiates both.
+template <class Executor>
+class basic_session : public std::enable_shared_from_this<basic_session<Executor>> {
+public:
+    using socket_type = typename tcp::socket::template rebind_executor<Executor>::other;
+
+private:
+    using stream_type = beast::basic_stream<tcp, Executor>;
+
+    // Finishes a deferred request (see response_queue::defer). Called from
+    // any thread with fn(response_queue&), which is run on the session's
+    // executor to send the response.
+    class deferred_send {
+        std::shared_ptr<basic_session> self_;
+
+    public:
+        explicit deferred_send(std::shared_ptr<basic_session> self) : self_(std::move(self)) {}
+
+        template <class Fn>
+        void operator()(Fn&& fn) const {
+            net::post(self_->stream_.get_executor(), [self = self_, fn = std::forward<Fn>(fn)]() mutable {
+                const std::uint64_t queued = self->queue_.queued();
+                fn(self->queue_);
+                self->on_handled(queued);
+            });
+        }
+    };
+
+    // Ordered queue of responses waiting to be written; the front one is
+    // being written
+    class response_queue {
+        struct work {
+            virtual ~work() = default;
+            virtual void operator()() = 0;
+        };
+
+        // A queued response, placed in its request's arena when it has one
+        class entry {
+            work* work_ = nullptr;
+            std::unique_ptr<request_arena> arena_;
+
+        public:
+            entry(work* w, std::unique_ptr<request_arena> arena) : work_(w), arena_(std::move(arena)) {}
+            entry(entry&& other) noexcept
+                : work_(std::exchange(other.work_, nullptr)), arena_(std::move(other.arena_))
+            {
+            }
+            entry& operator=(entry&&) = delete;
+            ~entry() { release(); }
 
-    // Define send_lambda inside session
-    struct send_lambda {
-        session& self_;
+            work& operator*() const { return *work_; }
 
-        explicit send_lambda(session& self) : self_(self) {}
+            // Destroys the response and hands back its arena, if any
+            std::unique_ptr<request_arena> release() {
+                if (work_) {
+                    if (arena_) {
+                        work_->~work();
+                    } else {
+                        delete work_;
+                    }
+                    work_ = nullptr;
+                }
+                return std::move(arena_);
+            }
+        };
 
+        basic_session& self_;
+        std::deque<entry, pool_allocator<entry>> items_;
+        std::uint64_t queued_ = 0;
+
+    public:
+        explicit response_queue(basic_session& self) : self_(self) {}
+
+        bool is_full() const { return items_.size() >= session_pipeline_limit; }
+        bool empty() const { return items_.empty(); }
+        // Responses queued since the session started
+        std::uint64_t queued() const { return queued_; }
+
+        // For a handler that cannot answer without waiting on other work: it
+        // returns without sending and later calls the returned object, from
+        // any thread, to send the response. Its request, and the arena it
+        // lives in, stay valid until then, and no further request is read.
+        deferred_send defer() { return deferred_send(self_.shared_from_this()); }
+
+        // Drops the responses not yet written
+        void clear() {
+            while (!items_.empty()) {
+                self_.recycle(items_.front().release());
+                items_.pop_front();
+            }
+        }
+
+        // Called when the front response was written; starts the next one.
+        // Returns true when the queue was full, so reading may resume.
+        bool on_write() {
+            const bool was_full = is_full();
+            self_.recycle(items_.front().release());
+            items_.pop_front();
+            if (!items_.empty()) {
+                (*items_.front())();
+            }
+            return was_full;
+        }
+
+        // Queues a response, writing it right away when nothing is pending
         template <bool isRequest, class Body, class Fields>
-        void operator()(http::message<isRequest, Body, Fields>&& msg) const {
-            auto sp = std::make_shared<
-                http::message<isRequest, Body, Fields>>(std::move(msg));
-
-            self_.res_ = sp;
-
-            // Write the response
-            http::async_write(
-                self_.stream_,
-                *sp,
-                beast::bind_front_handler(
-                    &session::on_write,
-                    self_.shared_from_this(),
-                    sp->need_eof()));
+        void operator()(http::message<isRequest, Body, Fields>&& msg) {
+            struct work_impl : work {
+                basic_session& self_;
+                http::message<isRequest, Body, Fields> msg_;
+                // Set for a HEAD request: only the header is written
+                std::optional<http::serializer<isRequest, Body, Fields>> header_only_;
+
+                work_impl(basic_session& self, http::message<isRequest, Body, Fields>&& msg, bool header_only)
+                    : self_(self), msg_(std::move(msg))
+                {
+                    if (header_only) {
+                        header_only_.emplace(msg_);
+                    }
+                }
+
+                void operator()() override {
+                    // The write gets its own deadline: the one set by
+                    // do_read only reaches operations started after it,
+                    // and a read may be pending while this write starts
+                    self_.stream_.expires_after(std::chrono::seconds(30));
+                    auto handler = beast::bind_front_handler(
+                        &basic_session::on_write,
+                        self_.shared_from_this(),
+                        msg_.need_eof());
+                    if (header_only_) {
+                        http::async_write_header(self_.stream_, *header_only_, std::move(handler));
+                    } else {
+                        http::async_write(self_.stream_, msg_, std::move(handler));
+                    }
+                }
+            };
+
+            // Nothing after a response that closes the connection is sent
+            if (msg.need_eof()) {
+                self_.closing_ = true;
+            }
+            // The first response to a request takes over its arena
+            std::unique_ptr<request_arena> arena = std::move(self_.arena_);
+            const bool header_only = std::exchange(self_.head_, false);
+            work* w = arena
+                ? new (arena->allocate(sizeof(work_impl), alignof(work_impl)))
+                      work_impl(self_, std::move(msg), header_only)
+                : new work_impl(self_, std::move(msg), header_only);
+            items_.emplace_back(w, std::move(arena));
+            ++queued_;
+            if (items_.size() == 1) {
+                (*items_.front())();
+            }
         }
     };
 
-    send_lambda lambda_;
+    stream_type stream_;
+    beast::basic_flat_buffer<pool_allocator<char>> buffer_;
+    std::shared_ptr<std::string const> doc_root_;
+    std::shared_ptr<IDatabase> db_;
+    std::unique_ptr<request_arena> arena_; // of the request being read
+    std::vector<std::unique_ptr<request_arena>, pool_allocator<std::unique_ptr<request_arena>>> spare_arenas_;
+    // Declared after the arenas so it is destroyed before them
+    boost::optional<http::request_parser<arena_string_body, arena_allocator>> parser_;
+    response_queue queue_;
+    bool reading_ = false;  // a read is outstanding
+    bool closing_ = false;  // no more requests are read
+    bool read_eof_ = false; // the client closed its side
+    bool deferred_ = false; // the last request read has not been answered yet
+    bool head_ = false;     // it is a HEAD request, answered with headers only
+
+    // Resets arena and keeps it for a later request
+    void recycle(std::unique_ptr<request_arena> arena);
 
 public:
     // Constructor
     //session(tcp::socket&& socket, std::shared_ptr<std::string const> const& doc_root);
-    session(tcp::socket&& socket, std::shared_ptr<std::string const> const& doc_root, std::shared_ptr<IDatabase> db);
+    basic_session(socket_type&& socket, std::shared_ptr<std::string const> const& doc_root, std::shared_ptr<IDatabase> db);
+    ~basic_session();
 
     void run();
 
 private:
     void do_read();
     void on_read(beast::error_code ec, std::size_t bytes_transferred);
+    // Called once a handler returns; queued is queue_.queued() before it ran
+    void on_handled(std::uint64_t queued);
     void on_write(bool close, beast::error_code ec, std::size_t bytes_transferred);
     void do_close();
 };
 
+using session = basic_session<shared_session_executor>;
+using core_session = basic_session<core_session_executor>;
+
 #endif
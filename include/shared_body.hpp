@@ -0,0 +1,47 @@
+// shared_body.hpp
+#ifndef SHARED_BODY_HPP
+#define SHARED_BODY_HPP
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/core/error.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+// A Body over an immutable string that several responses share, such as the
+// serialized result of a coalesced request (see request_coalescer.hpp). Each
+// response holds a reference rather than a copy, so sending the same bytes
+// to many clients costs one serialization and no per-client allocation.
+struct shared_body {
+    using value_type = std::shared_ptr<const std::string>;
+
+    static std::uint64_t size(const value_type& body) { return body ? body->size() : 0; }
+
+    class writer {
+        const value_type& body_;
+
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer(boost::beast::http::header<isRequest, Fields> const&, const value_type& body)
+            : body_(body)
+        {
+        }
+
+        void init(boost::beast::error_code& ec) { ec = {}; }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(boost::beast::error_code& ec) {
+            ec = {};
+            if (!body_ || body_->empty()) {
+                return boost::none;
+            }
+            return std::make_pair(const_buffers_type(body_->data(), body_->size()), false);
+        }
+    };
+};
+
+#endif // SHARED_BODY_HPP
@@ -0,0 +1,118 @@
+// single_flight.hpp
+#ifndef SINGLE_FLIGHT_HPP
+#define SINGLE_FLIGHT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Counters of a single_flight group since startup
+struct single_flight_stats {
+    std::uint64_t executed = 0;  // computations run
+    std::uint64_t coalesced = 0; // calls that shared another call's run
+    std::size_t in_flight = 0;   // keys being computed right now
+};
+
+// Coalesces concurrent calls that compute the same keyed value. The first
+// caller for a key runs the computation; callers that arrive while it runs,
+// from any thread, share its result. The key is dropped once the value is
+// ready, so nothing is cached: a later call computes afresh.
+//
+// A caller that must not block (an io thread) passes a waiter: when another
+// call is already running, run() returns at once and that call hands its
+// result to the waiter on its own thread once it finishes. Waiters should
+// only post the result to where it is needed. Without a waiter, run() blocks
+// until the result is ready. An exception thrown by the computation is
+// rethrown to the caller that ran it and to blocking callers, and passed to
+// waiters as result::error.
+template <class T>
+class single_flight {
+public:
+    struct result {
+        std::shared_ptr<const T> value;
+        bool coalesced = false;  // waited on another caller's computation
+        std::exception_ptr error; // thrown by that computation; waiters only
+    };
+
+    using waiter = std::function<void(result)>;
+
+    // compute() returns a T. Returns its result when this caller ran it, and
+    // nothing after queueing wait on a call already running.
+    template <class Fn>
+    std::optional<result> run(const std::string& key, Fn&& compute, waiter wait) {
+        {
+            std::lock_guard lock(mutex_);
+            auto it = calls_.find(key);
+            if (it != calls_.end()) {
+                coalesced_.fetch_add(1, std::memory_order_relaxed);
+                it->second.push_back(std::move(wait));
+                return std::nullopt;
+            }
+            executed_.fetch_add(1, std::memory_order_relaxed);
+            calls_.emplace(key, std::vector<waiter>{});
+        }
+
+        result out;
+        try {
+            out.value = std::make_shared<const T>(compute());
+        } catch (...) {
+            out.error = std::current_exception();
+        }
+        std::vector<waiter> waiting;
+        {
+            std::lock_guard lock(mutex_);
+            auto it = calls_.find(key);
+            waiting = std::move(it->second);
+            calls_.erase(it);
+        }
+        for (auto& w : waiting) {
+            w(result{out.value, true, out.error});
+        }
+        if (out.error) {
+            std::rethrow_exception(out.error);
+        }
+        return out;
+    }
+
+    // Blocking form, for callers off the io threads
+    template <class Fn>
+    result run(const std::string& key, Fn&& compute) {
+        auto ready = std::make_shared<std::promise<result>>();
+        std::future<result> shared = ready->get_future();
+        if (auto own = run(key, std::forward<Fn>(compute), [ready](result r) { ready->set_value(std::move(r)); })) {
+            return *own;
+        }
+        result r = shared.get();
+        if (r.error) {
+            std::rethrow_exception(r.error);
+        }
+        return r;
+    }
+
+    single_flight_stats stats() const {
+        single_flight_stats stats;
+        stats.executed = executed_.load(std::memory_order_relaxed);
+        stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+        std::lock_guard lock(mutex_);
+        stats.in_flight = calls_.size();
+        return stats;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<waiter>> calls_; // by key, with their waiters
+    std::atomic<std::uint64_t> executed_{0};
+    std::atomic<std::uint64_t> coalesced_{0};
+};
+
+#endif // SINGLE_FLIGHT_HPP
@@ -0,0 +1,205 @@
+// symbol_store.hpp
+#ifndef SYMBOL_STORE_HPP
+#define SYMBOL_STORE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "price_series.hpp"
+#include "single_flight.hpp"
+
+// Resident-series cache counters since startup
+struct symbol_cache_stats {
+    std::uint64_t hits = 0;      // get() served from memory
+    std::uint64_t misses = 0;    // get() or load_or_wait() of a symbol that was not resident
+    std::uint64_t evictions = 0; // series dropped to stay within the budget
+    std::uint64_t loads = 0;     // cold loads run
+    std::uint64_t coalesced_loads = 0; // misses that waited on a load already running
+    std::size_t resident = 0;    // symbols in memory
+    std::size_t bytes = 0;       // their estimated footprint
+    std::size_t capacity = 0;    // the budget; 0 is unbounded
+};
+
+// Process-wide cache of parsed price series, keyed by symbol (the CSV file
+// name without extension). Each file is parsed once; requests share the
+// immutable result. A current binary snapshot (<symbol>.capsnap, see
+// series_snapshot.hpp) is mapped instead of parsing the CSV.
+//
+// The catalog lists every symbol with a file in the data roots, resident or
+// not. Resident series live in shard_count shards picked by symbol hash, each
+// with its own lock and LRU list, so lookups of different symbols rarely
+// contend and a hit holds its shard's lock only to bump the entry. With a
+// memory budget, a write that takes the resident total over it evicts the
+// least recently used series of each shard in turn until the total fits;
+// get() loads them again on demand.
+// Requests still holding an evicted or replaced series keep it alive until
+// they finish.
+//
+// Writers (first loads and refresh/reload after a file change) are
+// serialized, build a new series off to the side and swap it into its shard.
+class symbol_store {
+public:
+    static symbol_store& getInstance() {
+        static symbol_store instance;
+        return instance;
+    }
+
+    symbol_store(const symbol_store&) = delete;
+    symbol_store& operator=(const symbol_store&) = delete;
+
+    // Sets the directory holding <symbol>.csv files
+    void set_data_root(const std::string& root);
+    std::string data_root() const;
+
+    // Sets the directory holding <symbol>.capsnap files; empty means the data root
+    void set_snapshot_root(const std::string& root);
+    // Checksum snapshots when opening them (reads every page up front)
+    void set_verify_snapshots(bool verify);
+
+    // Memory budget for resident series (columns, range index, pyramid and
+    // sketches; mapped snapshot pages are not counted). 0 is unbounded.
+    // Lowering it evicts at once.
+    void set_capacity_bytes(std::size_t bytes);
+
+    // Catalogs every CSV or snapshot in the data and snapshot roots and loads
+    // them until the budget is reached; returns the number of symbols loaded
+    std::size_t load_all();
+
+    // Returns the series for symbol, loading it when it is not resident.
+    // Returns nullptr when no such file exists; throws on malformed files.
+    std::shared_ptr<const price_series> get(std::string_view symbol);
+
+    // For callers that must not block on another caller's load (io
+    // threads). Returns true once symbol is resident, loading it on this
+    // thread if needed, or when it cannot be loaded; get() then does not
+    // wait. Returns false when another caller is loading it, after queueing
+    // ready to be called on that caller's thread when it is done.
+    bool load_or_wait(std::string_view symbol, std::function<void()> ready);
+
+    // The resident series for symbol, or nullptr; neither loads nor counts
+    // as a use
+    std::shared_ptr<const price_series> peek(std::string_view symbol) const;
+
+    // Resident symbols, sorted
+    std::vector<std::string> symbols() const;
+
+    // Cataloged symbols starting with prefix and sorting after `after`, at
+    // most limit of them, sorted. total receives the number of matches.
+    std::vector<std::string> catalog(std::string_view prefix, std::string_view after, std::size_t limit,
+                                     std::size_t* total = nullptr) const;
+
+    symbol_cache_stats cache_stats() const;
+
+    static constexpr std::size_t shard_count = 16;
+
+    // Estimated heap footprint of a series and its derived structures
+    static std::size_t resident_bytes(const price_series& series) noexcept;
+
+    // Picks up rows appended to symbol's CSV since it was last read: only the
+    // new bytes are parsed, and the result is published as a new version. A
+    // file that shrank is loaded from scratch; a symbol that is not resident
+    // is only (re)cataloged. With complete_lines_only, a trailing line
+    // without its newline is left for a later call, since the writer may be
+    // in the middle of it. Once a last line was parsed without its newline,
+    // anything written after it reloads the file instead. Errors are logged,
+    // and the previous version stays published.
+    void refresh(std::string_view symbol, bool complete_lines_only);
+
+    // Loads symbol from scratch (for a CSV that was replaced or deleted) when
+    // it is resident; a symbol with neither CSV nor snapshot left is dropped
+    void reload(std::string_view symbol);
+
+    // refresh() for every CSV in the data root and every loaded symbol
+    void refresh_all();
+
+    // Symbols are restricted to [A-Za-z0-9_-] so they can never escape the data root
+    static bool is_valid_symbol(std::string_view symbol) noexcept;
+
+private:
+    symbol_store() = default;
+
+    struct cache_entry {
+        std::shared_ptr<const price_series> series;
+        std::size_t bytes = 0;
+        std::list<std::string>::iterator lru;
+    };
+
+    // One lock stripe of the resident series
+    struct shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, cache_entry> entries;
+        std::list<std::string> lru; // most recently used first
+        std::size_t bytes = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    struct loaded_series {
+        std::shared_ptr<const price_series> series;
+        csv_extent csv; // of the CSV reflected in series; 0 bytes if none
+    };
+
+    std::string file_path(std::string_view symbol) const;
+    std::string snapshot_path(std::string_view symbol) const;
+
+    // Maps the symbol's snapshot when it is present and matches the CSV (or
+    // there is no CSV), otherwise parses the CSV. Null series if neither exists.
+    loaded_series load(std::string_view symbol) const;
+    // Loads symbol and publishes it unless a copy was published meanwhile;
+    // returns the resident series, or nullptr when there is no file
+    std::shared_ptr<const price_series> load_and_publish(const std::string& symbol);
+
+    shard& shard_of(std::string_view symbol) const;
+
+    // Writers only, with update_mutex_ held. A null series removes symbol.
+    void publish_locked(const std::string& symbol, std::shared_ptr<const price_series> series);
+    // Drops series other than keep while the resident total is over the
+    // budget, the least recently used of each shard in round-robin order.
+    // No shard lock may be held.
+    void evict_locked(const std::string* keep);
+    // Drops the least recently used series of s other than keep, with
+    // s.mutex held too; false when there is none
+    bool evict_one_locked(shard& s, const std::string* keep);
+    void refresh_locked(const std::string& symbol, bool complete_lines_only);
+    void reload_locked(const std::string& symbol);
+    void catalog_add(const std::string& symbol);
+    void catalog_remove(const std::string& symbol);
+    // Catalogs symbol when it has a CSV or snapshot, drops it otherwise
+    void recatalog(const std::string& symbol);
+    // Builds the range index, pyramid and return sketches of a published
+    // series on the compute pool and republishes it with them attached
+    void index_in_background(const std::string& symbol, std::shared_ptr<const price_series> series);
+
+    // Guards the settings below
+    mutable std::shared_mutex mutex_;
+    std::string data_root_ = "../data/";
+    std::string snapshot_root_;
+    bool verify_snapshots_ = false;
+
+    // Serializes writers; readers only lock the shard they look up
+    std::mutex update_mutex_;
+    mutable std::array<shard, shard_count> shards_;
+    std::atomic<std::size_t> capacity_{0};
+    std::atomic<std::size_t> resident_total_{0}; // bytes of all shards
+    std::size_t evict_cursor_ = 0;               // next shard to evict from; writers only
+    std::unordered_map<std::string, csv_extent> csv_extents_; // resident symbols only
+    // Concurrent misses on one symbol share a single load
+    single_flight<std::shared_ptr<const price_series>> loads_;
+
+    mutable std::shared_mutex catalog_mutex_;
+    std::set<std::string> catalog_;
+};
+
+#endif // SYMBOL_STORE_HPP
@@ -0,0 +1,63 @@
+// tdigest.hpp
+#ifndef TDIGEST_HPP
+#define TDIGEST_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Merging t-digest (Dunning & Ertl, "Computing extremely accurate quantiles
+// using t-digests"): a mergeable quantile sketch of weighted centroids. The
+// arcsine scale function keeps centroids small near the tails, so extreme
+// percentiles (VaR levels) stay accurate while the sketch holds at most
+// about compression centroids whatever the number of values.
+//
+// Values are buffered by add() and merge() and folded in by compress(),
+// which must run before quantile() and the accessors see them.
+class tdigest {
+public:
+    struct centroid {
+        double mean;
+        double weight;
+    };
+
+    static constexpr double default_compression = 100.0;
+
+    explicit tdigest(double compression = default_compression);
+
+    void add(double x, double weight = 1.0);
+    // Adds the centroids of other; exact when both are exact
+    void merge(const tdigest& other);
+    void compress();
+    // compress() and release spare capacity, for sketches that are kept
+    void shrink_to_fit();
+
+    // Value at quantile q in [0, 1], interpolated between centroid centres;
+    // NaN when empty
+    double quantile(double q) const;
+
+    // Upper bound on the rank error |q' - q| of quantile(q) for one sketch:
+    // half the widest centroid the scale function allows at q. Merging
+    // compressed sketches can add up to the same again.
+    double rank_error(double q) const noexcept;
+
+    double count() const noexcept { return total_; }
+    double min() const noexcept { return min_; }
+    double max() const noexcept { return max_; }
+    double compression() const noexcept { return compression_; }
+    const std::vector<centroid>& centroids() const noexcept { return centroids_; }
+
+    // True while every centroid is a single value, so quantiles are exact
+    bool exact() const noexcept { return static_cast<double>(centroids_.size()) == total_; }
+
+    std::size_t memory_bytes() const noexcept;
+
+private:
+    double compression_;
+    double total_ = 0.0;
+    double min_;
+    double max_;
+    std::vector<centroid> centroids_; // ascending by mean
+    std::vector<centroid> buffer_;    // not yet compressed
+};
+
+#endif // TDIGEST_HPP
@@ -0,0 +1,377 @@
+// compressed_series.cpp
+#include "compressed_series.hpp"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Appends bit fields, most significant bit first, to a vector of words
+class bit_writer {
+public:
+    explicit bit_writer(std::vector<std::uint64_t>& words) : words_(words) {}
+
+    std::uint64_t position() const noexcept { return position_; }
+
+    // Writes the low count bits of value; count in [1, 64]
+    void write(std::uint64_t value, unsigned count) {
+        if (count < 64) {
+            value &= (std::uint64_t{1} << count) - 1;
+        }
+        const unsigned used = static_cast<unsigned>(position_ % 64);
+        if (used == 0) {
+            words_.push_back(0);
+        }
+        const unsigned room = 64 - used;
+        if (count <= room) {
+            words_.back() |= value << (room - count);
+        } else {
+            words_.back() |= value >> (count - room);
+            words_.push_back(value << (64 - (count - room)));
+        }
+        position_ += count;
+    }
+
+private:
+    std::vector<std::uint64_t>& words_;
+    std::uint64_t position_ = 0;
+};
+
+class bit_reader {
+public:
+    bit_reader(const std::uint64_t* words, std::uint64_t position) : words_(words), position_(position) {}
+
+    // Reads count bits; count in [1, 64]
+    std::uint64_t read(unsigned count) noexcept {
+        const std::uint64_t* word = words_ + position_ / 64;
+        const unsigned used = static_cast<unsigned>(position_ % 64);
+        std::uint64_t value = word[0] << used;
+        if (used + count > 64) {
+            value |= word[1] >> (64 - used);
+        }
+        position_ += count;
+        return value >> (64 - count);
+    }
+
+    bool read_bit() noexcept {
+        const bool bit = (words_[position_ / 64] >> (63 - position_ % 64)) & 1;
+        ++position_;
+        return bit;
+    }
+
+private:
+    const std::uint64_t* words_;
+    std::uint64_t position_;
+};
+
+std::uint64_t zigzag(std::int64_t v) noexcept {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t v) noexcept {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+// Delta-of-delta widths, narrowest first
+constexpr unsigned dod_widths[] = {7, 9, 12, 64};
+
+std::uint64_t bits_of(double x) noexcept {
+    std::uint64_t v;
+    std::memcpy(&v, &x, sizeof v);
+    return v;
+}
+
+double double_of(std::uint64_t v) noexcept {
+    double x;
+    std::memcpy(&x, &v, sizeof x);
+    return x;
+}
+
+// Leading zeros are stored in 5 bits, so at most 31 are recorded
+constexpr unsigned max_leading = 31;
+
+// Nonzero variable-width field: bucket + 1 ones and a zero (none after the
+// last bucket) select the width of the value that follows. The first one
+// doubles as the flag that tells a nonzero field from a single zero bit.
+template <std::size_t N>
+void write_bucketed(bit_writer& out, std::uint64_t value, const unsigned (&widths)[N]) {
+    unsigned bucket = 0;
+    while (bucket + 1 < N && value >> widths[bucket]) {
+        ++bucket;
+    }
+    const std::uint64_t ones = (std::uint64_t{1} << (bucket + 1)) - 1;
+    if (bucket + 1 == N) {
+        out.write(ones, bucket + 1);
+    } else {
+        out.write(ones << 1, bucket + 2);
+    }
+    out.write(value, widths[bucket]);
+}
+
+template <std::size_t N>
+std::uint64_t read_bucketed(bit_reader& in, const unsigned (&widths)[N]) {
+    unsigned bucket = 0;
+    while (bucket + 1 < N && in.read_bit()) {
+        ++bucket;
+    }
+    return in.read(widths[bucket]);
+}
+
+void encode_days(bit_writer& out, const std::int32_t* days, std::size_t n) {
+    std::int64_t delta = 0;
+    for (std::size_t i = 1; i < n; ++i) {
+        const std::int64_t next = static_cast<std::int64_t>(days[i]) - days[i - 1];
+        const std::uint64_t dod = zigzag(next - delta);
+        delta = next;
+        if (dod == 0) {
+            out.write(0, 1);
+        } else {
+            write_bucketed(out, dod, dod_widths);
+        }
+    }
+}
+
+void decode_day_run(bit_reader& in, std::int32_t first_day, std::int32_t* out, std::size_t n) {
+    out[0] = first_day;
+    std::int64_t delta = 0;
+    for (std::size_t i = 1; i < n; ++i) {
+        if (in.read_bit()) {
+            delta += unzigzag(read_bucketed(in, dod_widths));
+        }
+        out[i] = static_cast<std::int32_t>(out[i - 1] + delta);
+    }
+}
+
+// Cent deltas of decimal-mode runs
+constexpr unsigned cent_widths[] = {6, 10, 16, 32, 64};
+constexpr double cents_per_unit = 100.0;
+
+// Missing values (a CSV's empty Vol.) inside a decimal-mode run
+const std::uint64_t missing_bits = bits_of(std::numeric_limits<double>::quiet_NaN());
+
+// Whole cents of x when cents / 100 gives back exactly x
+std::optional<std::int64_t> exact_cents(double x) {
+    if (!(std::abs(x) < 1e15)) {
+        return std::nullopt; // NaN, infinities, and values past exact integers
+    }
+    const std::int64_t c = std::llround(x * cents_per_unit);
+    if (bits_of(static_cast<double>(c) / cents_per_unit) != bits_of(x)) {
+        return std::nullopt;
+    }
+    return c;
+}
+
+void encode_doubles(bit_writer& out, const double* values, std::size_t n) {
+    // Decimal mode: prices and percentages in the CSVs carry two decimals,
+    // which no binary fraction holds exactly, so their XORs stay wide. When
+    // every value of the run is a whole number of cents or missing, a
+    // presence bitmap (only if something is missing) and the cent deltas of
+    // the present values are stored instead.
+    std::vector<std::int64_t> cents;
+    cents.reserve(n);
+    bool missing = false;
+    std::size_t i = 0;
+    for (; i < n; ++i) {
+        if (bits_of(values[i]) == missing_bits) {
+            missing = true;
+        } else if (auto c = exact_cents(values[i])) {
+            cents.push_back(*c);
+        } else {
+            break;
+        }
+    }
+    if (i == n) {
+        out.write(1, 1);
+        out.write(missing, 1);
+        if (missing) {
+            for (std::size_t k = 0; k < n; ++k) {
+                out.write(bits_of(values[k]) != missing_bits, 1);
+            }
+        }
+        std::int64_t prev = 0;
+        for (std::int64_t c : cents) {
+            if (c == prev) {
+                out.write(0, 1);
+            } else {
+                write_bucketed(out, zigzag(c - prev), cent_widths);
+            }
+            prev = c;
+        }
+        return;
+    }
+
+    out.write(0, 1);
+    std::uint64_t prev = bits_of(values[0]);
+    out.write(prev, 64);
+    unsigned leading = 64; // no window yet
+    unsigned trailing = 0;
+    for (std::size_t i = 1; i < n; ++i) {
+        const std::uint64_t next = bits_of(values[i]);
+        const std::uint64_t x = next ^ prev;
+        prev = next;
+        if (x == 0) {
+            out.write(0, 1);
+            continue;
+        }
+        const unsigned lz = std::min<unsigned>(static_cast<unsigned>(__builtin_clzll(x)), max_leading);
+        const unsigned tz = static_cast<unsigned>(__builtin_ctzll(x));
+        if (leading != 64 && lz >= leading && tz >= trailing) {
+            out.write(0b10, 2);
+            out.write(x >> trailing, 64 - leading - trailing);
+        } else {
+            leading = lz;
+            trailing = tz;
+            const unsigned width = 64 - lz - tz;
+            out.write(0b11, 2);
+            out.write(lz, 5);
+            out.write(width, 6); // 64 wraps to 0
+            out.write(x >> tz, width);
+        }
+    }
+}
+
+void decode_double_run(bit_reader& in, double* out, std::size_t n) {
+    if (in.read_bit()) {
+        const bool missing = in.read_bit();
+        if (missing) {
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = in.read_bit() ? 0.0 : double_of(missing_bits);
+            }
+        }
+        std::int64_t c = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (missing && std::isnan(out[i])) {
+                continue;
+            }
+            if (in.read_bit()) {
+                c += unzigzag(read_bucketed(in, cent_widths));
+            }
+            out[i] = static_cast<double>(c) / cents_per_unit;
+        }
+        return;
+    }
+
+    std::uint64_t prev = in.read(64);
+    out[0] = double_of(prev);
+    unsigned leading = 0;
+    unsigned trailing = 0;
+    for (std::size_t i = 1; i < n; ++i) {
+        if (in.read_bit()) {
+            if (in.read_bit()) {
+                leading = static_cast<unsigned>(in.read(5));
+                unsigned width = static_cast<unsigned>(in.read(6));
+                trailing = 64 - leading - (width == 0 ? 64 : width);
+            }
+            prev ^= in.read(64 - leading - trailing) << trailing;
+        }
+        out[i] = double_of(prev);
+    }
+}
+
+template <class T>
+void assign(series_column<T>& column, const T* values, std::size_t n) {
+    column.values().insert(column.values().end(), values, values + n);
+}
+
+} // namespace
+
+std::size_t compressed_series::slot_of(series_field column) {
+    switch (column) {
+        case field_date: return 0;
+        case field_price: return 1;
+        case field_open: return 2;
+        case field_high: return 3;
+        case field_low: return 4;
+        case field_volume: return 5;
+        case field_change_percent: return 6;
+        default: throw std::invalid_argument("Not a single series column");
+    }
+}
+
+compressed_series::compressed_series(const price_series& series)
+    : symbol_(series.symbol),
+      rows_(series.size())
+{
+    const series_column<double>* columns[] = {
+        &series.price, &series.open, &series.high, &series.low, &series.volume, &series.change_percent};
+    bit_writer out(bits_);
+    directory_.reserve((rows_ + block_rows - 1) / block_rows);
+    for (std::size_t first = 0; first < rows_; first += block_rows) {
+        const std::size_t n = std::min(block_rows, rows_ - first);
+        block_entry& entry = directory_.emplace_back();
+        entry.first_day = series.day[first];
+        entry.offsets[0] = out.position();
+        encode_days(out, series.day.data() + first, n);
+        for (std::size_t c = 0; c < std::size(columns); ++c) {
+            entry.offsets[c + 1] = out.position();
+            encode_doubles(out, columns[c]->data() + first, n);
+        }
+    }
+    bits_.shrink_to_fit();
+}
+
+std::size_t compressed_series::decode_days(std::size_t block, std::int32_t* out) const {
+    const std::size_t n = std::min(block_rows, rows_ - block * block_rows);
+    bit_reader in(bits_.data(), directory_[block].offsets[0]);
+    decode_day_run(in, directory_[block].first_day, out, n);
+    return n;
+}
+
+std::size_t compressed_series::decode_block(std::size_t block, series_field column, double* out) const {
+    const std::size_t slot = slot_of(column);
+    if (slot == 0) {
+        throw std::invalid_argument("Dates are decoded by decode_days");
+    }
+    const std::size_t n = std::min(block_rows, rows_ - block * block_rows);
+    bit_reader in(bits_.data(), directory_[block].offsets[slot]);
+    decode_double_run(in, out, n);
+    return n;
+}
+
+row_range compressed_series::find_day_range(std::optional<std::int32_t> from,
+                                            std::optional<std::int32_t> to) const {
+    // Row of the first day after day (upper) or not before it: only the
+    // block the boundary falls in is decoded
+    auto bound = [&](std::int32_t day, bool upper) -> std::size_t {
+        auto after = std::partition_point(directory_.begin(), directory_.end(), [&](const block_entry& e) {
+            return upper ? e.first_day <= day : e.first_day < day;
+        });
+        if (after == directory_.begin()) {
+            return 0;
+        }
+        const std::size_t block = static_cast<std::size_t>(after - directory_.begin()) - 1;
+        std::int32_t days[block_rows];
+        const std::size_t n = decode_days(block, days);
+        const std::int32_t* it = upper ? std::upper_bound(days, days + n, day) : std::lower_bound(days, days + n, day);
+        return block * block_rows + static_cast<std::size_t>(it - days);
+    };
+    const std::size_t begin = from ? bound(*from, false) : 0;
+    const std::size_t end = to ? bound(*to, true) : rows_;
+    return {begin, std::max(begin, end)};
+}
+
+price_series compressed_series::decompress() const {
+    price_series series;
+    series.symbol = symbol_;
+    series.reserve(rows_);
+    series_column<double>* columns[] = {
+        &series.price, &series.open, &series.high, &series.low, &series.volume, &series.change_percent};
+    std::int32_t days[block_rows];
+    double values[block_rows];
+    for (std::size_t b = 0; b < directory_.size(); ++b) {
+        const std::size_t n = decode_days(b, days);
+        assign(series.day, days, n);
+        for (std::size_t c = 0; c < std::size(columns); ++c) {
+            bit_reader in(bits_.data(), directory_[b].offsets[c + 1]);
+            decode_double_run(in, values, n);
+            assign(*columns[c], values, n);
+        }
+    }
+    return series;
+}
+
+std::size_t compressed_series::memory_bytes() const noexcept {
+    return symbol_.capacity() + directory_.capacity() * sizeof(block_entry) +
+           bits_.capacity() * sizeof(std::uint64_t);
+}
@@ -0,0 +1,129 @@
+// compute_pool.cpp
+#include "compute_pool.hpp"
+#include <boost/asio/post.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "spdlog/spdlog.h"
+
+namespace {
+
+std::atomic<std::size_t> requested_threads{0};
+
+// Set while a thread executes a parallel_for or posted task
+thread_local bool in_parallel_task = false;
+
+// Marks the current thread as running a task until destroyed, however the
+// task exits
+class parallel_task_scope {
+    bool nested_ = in_parallel_task;
+
+public:
+    parallel_task_scope() { in_parallel_task = true; }
+    ~parallel_task_scope() { in_parallel_task = nested_; }
+    parallel_task_scope(const parallel_task_scope&) = delete;
+    parallel_task_scope& operator=(const parallel_task_scope&) = delete;
+};
+
+} // namespace
+
+void compute_pool::set_thread_count(std::size_t threads) {
+    requested_threads.store(threads);
+}
+
+compute_pool& compute_pool::getInstance() {
+    static compute_pool instance([] {
+        std::size_t n = requested_threads.load();
+        if (n == 0) {
+            n = std::max(1u, std::thread::hardware_concurrency());
+        }
+        return n;
+    }());
+    return instance;
+}
+
+compute_pool::compute_pool(std::size_t threads)
+    : threads_(threads), pool_(threads)
+{
+}
+
+void compute_pool::parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || in_parallel_task) {
+        for (std::size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    // Indices are claimed from a shared counter by the caller and by helper
+    // tasks alike. The caller keeps claiming until none are left, so it only
+    // ever waits for tasks already running, never for ones still queued
+    // behind pool threads that may be blocked (on a lock the caller holds,
+    // for instance). Helpers that start after the work is gone do nothing;
+    // the state is shared so they may outlive this call.
+    struct state {
+        std::atomic<std::size_t> next{0};
+        std::size_t count = 0;
+        const std::function<void(std::size_t)>* fn = nullptr;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::size_t finished = 0;
+        std::exception_ptr error;
+    };
+    auto shared = std::make_shared<state>();
+    shared->count = count;
+    shared->fn = &fn;
+
+    auto work = [](state& st) {
+        for (std::size_t i; (i = st.next.fetch_add(1)) < st.count;) {
+            // fn stays alive until every claimed index has finished
+            try {
+                parallel_task_scope scope;
+                (*st.fn)(i);
+            } catch (...) {
+                std::lock_guard lock(st.mutex);
+                if (!st.error) {
+                    st.error = std::current_exception();
+                }
+            }
+            std::lock_guard lock(st.mutex);
+            if (++st.finished == st.count) {
+                st.done.notify_one();
+            }
+        }
+    };
+
+    const std::size_t helpers = std::min(count - 1, threads_);
+    for (std::size_t i = 0; i < helpers; ++i) {
+        boost::asio::post(pool_, [shared, work] { work(*shared); });
+    }
+    work(*shared);
+
+    std::unique_lock lock(shared->mutex);
+    shared->done.wait(lock, [&] { return shared->finished == count; });
+    if (shared->error) {
+        std::rethrow_exception(shared->error);
+    }
+}
+
+void compute_pool::post(std::function<void()> fn) {
+    boost::asio::post(pool_, [fn = std::move(fn)] {
+        // Nobody waits on fn, so an exception would otherwise escape the
+        // pool thread and terminate the server
+        parallel_task_scope scope;
+        try {
+            fn();
+        } catch (const std::exception& e) {
+            spdlog::error("Background compute task failed: {}", e.what());
+        } catch (...) {
+            spdlog::error("Background compute task failed with an unknown exception");
+        }
+    });
+}
@@ -0,0 +1,205 @@
+// connection_pool.cpp
+#include "connection_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+
+namespace {
+
+constexpr std::size_t class_count = 11; // 64 B .. 64 KiB in powers of two
+static_assert(connection_pool::min_block_bytes << (class_count - 1) == connection_pool::max_block_bytes);
+
+std::size_t class_of(std::size_t bytes) {
+    std::size_t index = 0;
+    while ((connection_pool::min_block_bytes << index) < bytes) {
+        ++index;
+    }
+    return index;
+}
+
+struct free_block {
+    free_block* next;
+};
+
+// One thread's caches. Counters are atomics only so that stats() can read
+// them from another thread; they are written by the owner alone.
+struct thread_pool {
+    struct size_class {
+        free_block* head = nullptr;
+        std::atomic<std::size_t> cached{0};
+        std::atomic<std::uint64_t> reused{0};
+        std::atomic<std::uint64_t> fresh{0};
+    };
+    std::array<size_class, class_count> classes;
+    std::vector<std::unique_ptr<request_arena>> arenas;
+    std::atomic<std::size_t> arenas_cached{0};
+    std::atomic<std::size_t> arenas_cached_bytes{0};
+    std::atomic<std::uint64_t> arenas_reused{0};
+    std::atomic<std::uint64_t> arenas_fresh{0};
+
+    thread_pool();
+    ~thread_pool();
+};
+
+// Pools of running threads, and the counters of those that exited
+std::mutex registry_mutex;
+std::vector<thread_pool*>& registry() {
+    static std::vector<thread_pool*> pools;
+    return pools;
+}
+connection_pool_stats& retired() {
+    static connection_pool_stats stats;
+    return stats;
+}
+
+std::atomic<std::size_t> live_sessions{0};
+
+// The thread's pool once created. Null again after it is destroyed, when
+// memory freed during thread exit goes straight back to the heap.
+thread_local thread_pool* current_pool = nullptr;
+thread_local bool pool_destroyed = false;
+
+thread_pool::thread_pool() {
+    std::lock_guard lock(registry_mutex);
+    registry().push_back(this);
+    current_pool = this;
+}
+
+thread_pool::~thread_pool() {
+    current_pool = nullptr;
+    pool_destroyed = true;
+    std::lock_guard lock(registry_mutex);
+    auto& pools = registry();
+    pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+    connection_pool_stats& totals = retired();
+    totals.classes.resize(class_count);
+    for (std::size_t i = 0; i < class_count; ++i) {
+        totals.classes[i].reused += classes[i].reused;
+        totals.classes[i].fresh += classes[i].fresh;
+        while (free_block* block = classes[i].head) {
+            classes[i].head = block->next;
+            ::operator delete(block);
+        }
+    }
+    totals.arenas_reused += arenas_reused;
+    totals.arenas_fresh += arenas_fresh;
+}
+
+// The calling thread's pool, created on first use
+thread_pool* pool() {
+    if (!current_pool && !pool_destroyed) {
+        static thread_local thread_pool instance;
+    }
+    return current_pool;
+}
+
+} // namespace
+
+namespace connection_pool {
+
+void* allocate(std::size_t bytes) {
+    if (bytes > max_block_bytes) {
+        return ::operator new(bytes);
+    }
+    std::size_t index = class_of(bytes);
+    thread_pool* p = pool();
+    if (!p) {
+        return ::operator new(min_block_bytes << index);
+    }
+    auto& c = p->classes[index];
+    if (free_block* block = c.head) {
+        c.head = block->next;
+        c.cached.store(c.cached.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        c.reused.store(c.reused.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return block;
+    }
+    c.fresh.store(c.fresh.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return ::operator new(min_block_bytes << index);
+}
+
+void deallocate(void* ptr, std::size_t bytes) noexcept {
+    if (!ptr) {
+        return;
+    }
+    if (bytes > max_block_bytes) {
+        ::operator delete(ptr);
+        return;
+    }
+    std::size_t index = class_of(bytes);
+    thread_pool* p = current_pool;
+    std::size_t limit = std::max<std::size_t>(4, max_cached_bytes_per_class / (min_block_bytes << index));
+    if (!p || p->classes[index].cached.load(std::memory_order_relaxed) >= limit) {
+        ::operator delete(ptr);
+        return;
+    }
+    auto& c = p->classes[index];
+    c.head = new (ptr) free_block{c.head};
+    c.cached.store(c.cached.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+std::unique_ptr<request_arena> take_arena() {
+    thread_pool* p = pool();
+    if (p && !p->arenas.empty()) {
+        std::unique_ptr<request_arena> arena = std::move(p->arenas.back());
+        p->arenas.pop_back();
+        p->arenas_cached.store(p->arenas.size(), std::memory_order_relaxed);
+        p->arenas_cached_bytes.store(p->arenas_cached_bytes.load(std::memory_order_relaxed) - arena->capacity(),
+                                     std::memory_order_relaxed);
+        p->arenas_reused.store(p->arenas_reused.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return arena;
+    }
+    if (p) {
+        p->arenas_fresh.store(p->arenas_fresh.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    return std::make_unique<request_arena>();
+}
+
+void give_arena(std::unique_ptr<request_arena> arena) noexcept {
+    thread_pool* p = current_pool;
+    if (!arena || !p || p->arenas.size() >= max_cached_arenas) {
+        return;
+    }
+    arena->reset();
+    std::size_t bytes = p->arenas_cached_bytes.load(std::memory_order_relaxed) + arena->capacity();
+    if (bytes > max_cached_arena_bytes) {
+        return;
+    }
+    p->arenas.push_back(std::move(arena));
+    p->arenas_cached.store(p->arenas.size(), std::memory_order_relaxed);
+    p->arenas_cached_bytes.store(bytes, std::memory_order_relaxed);
+}
+
+void session_opened() noexcept {
+    live_sessions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void session_closed() noexcept {
+    live_sessions.fetch_sub(1, std::memory_order_relaxed);
+}
+
+connection_pool_stats stats() {
+    std::lock_guard lock(registry_mutex);
+    connection_pool_stats stats = retired();
+    stats.classes.resize(class_count);
+    for (std::size_t i = 0; i < class_count; ++i) {
+        stats.classes[i].bytes = min_block_bytes << i;
+    }
+    for (const thread_pool* p : registry()) {
+        for (std::size_t i = 0; i < class_count; ++i) {
+            stats.classes[i].cached += p->classes[i].cached.load(std::memory_order_relaxed);
+            stats.classes[i].reused += p->classes[i].reused.load(std::memory_order_relaxed);
+            stats.classes[i].fresh += p->classes[i].fresh.load(std::memory_order_relaxed);
+        }
+        stats.arenas_cached += p->arenas_cached.load(std::memory_order_relaxed);
+        stats.arenas_cached_bytes += p->arenas_cached_bytes.load(std::memory_order_relaxed);
+        stats.arenas_reused += p->arenas_reused.load(std::memory_order_relaxed);
+        stats.arenas_fresh += p->arenas_fresh.load(std::memory_order_relaxed);
+    }
+    stats.threads = registry().size();
+    stats.live_sessions = live_sessions.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace connection_pool
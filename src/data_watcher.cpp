@@ -0,0 +1,130 @@
+// data_watcher.cpp
+#include "data_watcher.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include "compute_pool.hpp"
+#include "spdlog/spdlog.h"
+
+namespace net = boost::asio;
+
+data_watcher::data_watcher(net::io_context& ioc, symbol_store& store)
+    : store_(store), root_(store.data_root()), descriptor_(ioc)
+{
+}
+
+void data_watcher::run() {
+    int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "inotify_init1");
+    }
+    constexpr std::uint32_t mask =
+        IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF;
+    if (::inotify_add_watch(fd, root_.c_str(), mask) < 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "inotify_add_watch " + root_);
+    }
+    descriptor_.assign(fd);
+    spdlog::info("Watching {} for data changes", root_);
+
+    do_read();
+
+    // Catch up on anything written between the initial load and the watch
+    compute_pool::getInstance().post([self = shared_from_this()] {
+        self->store_.refresh_all();
+    });
+}
+
+void data_watcher::do_read() {
+    descriptor_.async_read_some(
+        net::buffer(buffer_),
+        [self = shared_from_this()](boost::system::error_code ec, std::size_t bytes) {
+            self->on_read(ec, bytes);
+        });
+}
+
+void data_watcher::on_read(boost::system::error_code ec, std::size_t bytes) {
+    if (ec) {
+        if (ec != net::error::operation_aborted) {
+            spdlog::error("Data watcher on {} stopped: {}", root_, ec.message());
+        }
+        return;
+    }
+
+    for (std::size_t pos = 0; pos + sizeof(inotify_event) <= bytes;) {
+        inotify_event event;
+        std::memcpy(&event, buffer_ + pos, sizeof(event));
+        const char* name = buffer_ + pos + sizeof(inotify_event);
+        pos += sizeof(inotify_event) + event.len;
+
+        if (event.mask & IN_Q_OVERFLOW) {
+            spdlog::warn("Data watcher queue overflowed; rescanning {}", root_);
+            compute_pool::getInstance().post([self = shared_from_this()] {
+                self->store_.refresh_all();
+            });
+            continue;
+        }
+        if (event.mask & (IN_DELETE_SELF | IN_IGNORED)) {
+            spdlog::warn("Data root {} is no longer watched", root_);
+            continue;
+        }
+        if (event.len == 0) {
+            continue;
+        }
+
+        std::filesystem::path file(std::string(name, ::strnlen(name, event.len)));
+        if (file.extension() != ".csv") {
+            continue;
+        }
+        std::string symbol = file.stem().string();
+        if (!symbol_store::is_valid_symbol(symbol)) {
+            continue;
+        }
+
+        if (event.mask & (IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)) {
+            schedule(std::move(symbol), change::replaced);
+        } else if (event.mask & IN_CLOSE_WRITE) {
+            schedule(std::move(symbol), change::appended);
+        } else if (event.mask & IN_MODIFY) {
+            schedule(std::move(symbol), change::appended_lines);
+        }
+    }
+
+    do_read();
+}
+
+void data_watcher::schedule(std::string symbol, change what) {
+    {
+        std::lock_guard lock(pending_mutex_);
+        auto [it, inserted] = pending_.try_emplace(symbol, what);
+        if (!inserted) {
+            // Already queued; make sure the queued task does enough
+            if (what > it->second) {
+                it->second = what;
+            }
+            return;
+        }
+    }
+
+    compute_pool::getInstance().post([self = shared_from_this(), symbol = std::move(symbol)] {
+        change what;
+        {
+            // Taken off the list before running, so events that arrive while
+            // the refresh is in progress queue another one
+            std::lock_guard lock(self->pending_mutex_);
+            auto it = self->pending_.find(symbol);
+            what = it->second;
+            self->pending_.erase(it);
+        }
+        if (what == change::replaced) {
+            self->store_.reload(symbol);
+        } else {
+            self->store_.refresh(symbol, what == change::appended_lines);
+        }
+    });
+}
@@ -0,0 +1,317 @@
+// indicators.cpp
+#include "indicators.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Value of an indicator while its window fills
+constexpr double not_ready = std::numeric_limits<double>::quiet_NaN();
+
+const char* const value_names[] = {"Value"};
+const char* const macd_names[] = {"Histogram", "MACD", "Signal"};
+const char* const bollinger_names[] = {"Lower", "Middle", "Upper"};
+
+void check_period(const char* name, std::size_t n) {
+    if (n == 0 || n > indicator_max_period) {
+        throw std::invalid_argument(std::string(name) + " must be between 1 and " +
+                                    std::to_string(indicator_max_period));
+    }
+}
+
+} // namespace
+
+indicator_kind parse_indicator_kind(std::string_view name) {
+    static constexpr std::pair<std::string_view, indicator_kind> names[] = {
+        {"sma", indicator_kind::sma},
+        {"ema", indicator_kind::ema},
+        {"rsi", indicator_kind::rsi},
+        {"macd", indicator_kind::macd},
+        {"bollinger", indicator_kind::bollinger},
+    };
+    for (const auto& [n, kind] : names) {
+        if (n == name) {
+            return kind;
+        }
+    }
+    throw std::invalid_argument("Unknown indicator: '" + std::string(name) + "'");
+}
+
+const char* indicator_kind_name(indicator_kind kind) noexcept {
+    switch (kind) {
+        case indicator_kind::sma: return "sma";
+        case indicator_kind::ema: return "ema";
+        case indicator_kind::rsi: return "rsi";
+        case indicator_kind::macd: return "macd";
+        case indicator_kind::bollinger: return "bollinger";
+    }
+    return "sma";
+}
+
+indicator_spec indicator_spec::defaults(indicator_kind kind) noexcept {
+    indicator_spec spec;
+    spec.kind = kind;
+    if (kind == indicator_kind::rsi) {
+        spec.period = 14;
+    }
+    return spec;
+}
+
+void indicator_spec::validate() const {
+    if (kind == indicator_kind::macd) {
+        check_period("fast", fast);
+        check_period("slow", slow);
+        check_period("signal", signal);
+        if (fast >= slow) {
+            throw std::invalid_argument("fast must be shorter than slow");
+        }
+        return;
+    }
+    check_period("period", period);
+    if (kind == indicator_kind::bollinger && !(width > 0.0 && std::isfinite(width))) {
+        throw std::invalid_argument("k must be a positive number");
+    }
+}
+
+std::string indicator_spec::key() const {
+    std::string out = indicator_kind_name(kind);
+    out += '(';
+    if (kind == indicator_kind::macd) {
+        out += std::to_string(fast) + ',' + std::to_string(slow) + ',' + std::to_string(signal);
+    } else {
+        out += std::to_string(period);
+        if (kind == indicator_kind::bollinger) {
+            // Shortest form that reads back as the same double
+            char buf[32];
+            auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), width);
+            out += ',';
+            out.append(buf, ec == std::errc() ? end : buf);
+        }
+    }
+    out += ')';
+    return out;
+}
+
+std::size_t indicator_spec::outputs() const noexcept {
+    return kind == indicator_kind::macd || kind == indicator_kind::bollinger ? 3 : 1;
+}
+
+const char* const* indicator_spec::output_names() const noexcept {
+    switch (kind) {
+        case indicator_kind::macd: return macd_names;
+        case indicator_kind::bollinger: return bollinger_names;
+        default: return value_names;
+    }
+}
+
+double indicator_state::ema::push(double x) noexcept {
+    if (seen < n) {
+        // Seed with the running mean of the first n inputs
+        ++seen;
+        value += (x - value) / static_cast<double>(seen);
+        return seen == n ? value : not_ready;
+    }
+    value += alpha * (x - value);
+    return value;
+}
+
+indicator_state::indicator_state(const indicator_spec& spec)
+    : spec_(spec), fast_(spec.fast), slow_(spec.slow), signal_(spec.signal)
+{
+    if (spec.kind == indicator_kind::sma || spec.kind == indicator_kind::bollinger) {
+        window_.resize(spec.period);
+    } else if (spec.kind == indicator_kind::ema) {
+        fast_ = ema(spec.period);
+    }
+}
+
+double indicator_state::push_window(double price) noexcept {
+    const std::size_t n = window_.size();
+    if (count_ < n) {
+        // Welford's update while the window fills
+        ++count_;
+        const double delta = price - mean_;
+        mean_ += delta / static_cast<double>(count_);
+        m2_ += delta * (price - mean_);
+    } else {
+        // Replace the oldest close: mean and M2 move by the difference alone
+        const double old = window_[next_];
+        const double old_mean = mean_;
+        mean_ += (price - old) / static_cast<double>(n);
+        m2_ = std::max(m2_ + (price - old) * (price - mean_ + old - old_mean), 0.0);
+    }
+    window_[next_] = price;
+    next_ = next_ + 1 == n ? 0 : next_ + 1;
+    return count_ == n ? mean_ : not_ready;
+}
+
+void indicator_state::push(double price, double* out) {
+    switch (spec_.kind) {
+        case indicator_kind::sma:
+            out[0] = push_window(price);
+            break;
+        case indicator_kind::ema:
+            out[0] = fast_.push(price);
+            break;
+        case indicator_kind::rsi: {
+            const std::size_t n = spec_.period;
+            out[0] = not_ready;
+            if (count_++ > 0) {
+                const double change = price - previous_;
+                const double g = change > 0.0 ? change : 0.0;
+                const double l = change < 0.0 ? -change : 0.0;
+                if (count_ <= n + 1) {
+                    // The first averages are plain means of n changes
+                    gain_ += g / static_cast<double>(n);
+                    loss_ += l / static_cast<double>(n);
+                } else {
+                    gain_ += (g - gain_) / static_cast<double>(n);
+                    loss_ += (l - loss_) / static_cast<double>(n);
+                }
+                if (count_ > n) {
+                    out[0] = loss_ > 0.0 ? 100.0 - 100.0 / (1.0 + gain_ / loss_) : (gain_ > 0.0 ? 100.0 : 50.0);
+                }
+            }
+            previous_ = price;
+            break;
+        }
+        case indicator_kind::macd: {
+            const double fast = fast_.push(price);
+            const double slow = slow_.push(price);
+            const double line = slow_.ready() ? fast - slow : not_ready;
+            const double signal = slow_.ready() ? signal_.push(line) : not_ready;
+            out[0] = line - signal; // histogram
+            out[1] = line;
+            out[2] = signal;
+            break;
+        }
+        case indicator_kind::bollinger: {
+            const double middle = push_window(price);
+            const double sd = std::sqrt(m2_ / static_cast<double>(window_.size()));
+            out[0] = middle - spec_.width * sd;
+            out[1] = middle;
+            out[2] = middle + spec_.width * sd;
+            break;
+        }
+    }
+}
+
+std::size_t indicator_series::extend(const price_series& series) {
+    if (lineage != series.lineage || rows > series.size()) {
+        // Earlier rows changed: start over
+        state = indicator_state(spec);
+        values.clear();
+        rows = 0;
+        lineage = series.lineage;
+    }
+    const std::size_t start = rows;
+    const std::size_t width = spec.outputs();
+    values.resize(series.size() * width);
+    for (std::size_t i = start; i < series.size(); ++i) {
+        state.push(series.price[i], values.data() + i * width);
+    }
+    rows = series.size();
+    return rows - start;
+}
+
+std::size_t indicator_series::memory_bytes() const noexcept {
+    return sizeof(*this) + values.capacity() * sizeof(double) + state.memory_bytes();
+}
+
+void indicator_cache::set_capacity_bytes(std::size_t bytes) {
+    std::lock_guard lock(mutex_);
+    capacity_ = bytes;
+    evict_locked(nullptr);
+}
+
+std::string indicator_cache::cache_key(const std::string& symbol, const indicator_spec& spec) {
+    return symbol + '/' + spec.key();
+}
+
+std::shared_ptr<indicator_series> indicator_cache::get(const std::string& symbol, const indicator_spec& spec) {
+    std::string key = cache_key(symbol, spec);
+    std::lock_guard lock(mutex_);
+    if (capacity_ == 0) {
+        return std::make_shared<indicator_series>(spec);
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->entry;
+    }
+    auto entry = std::make_shared<indicator_series>(spec);
+    lru_.push_front(node{key, entry, 0});
+    index_.emplace(std::move(key), lru_.begin());
+    return entry;
+}
+
+indicator_view indicator_cache::compute(const std::string& symbol, const price_series& series,
+                                        const indicator_spec& spec) {
+    indicator_view view;
+    view.entry = get(symbol, spec);
+    view.lock = std::shared_lock(view.entry->mutex);
+    if (view.entry->covers(series)) {
+        return view;
+    }
+    view.lock.unlock();
+    {
+        std::unique_lock write(view.entry->mutex);
+        if (!view.entry->covers(series)) {
+            const bool same = view.entry->lineage == series.lineage && view.entry->rows > 0;
+            view.entry->extend(series);
+            view.cache = same ? "extended" : "computed";
+            update_size(symbol, *view.entry);
+        }
+    }
+    view.lock.lock();
+    if (!view.entry->covers(series)) {
+        // A request on another version of the symbol moved the entry on
+        // in between; compute this one privately rather than contend
+        view.lock.unlock();
+        view.entry = std::make_shared<indicator_series>(spec);
+        view.entry->extend(series);
+        view.lock = std::shared_lock(view.entry->mutex);
+        view.cache = "computed";
+    }
+    return view;
+}
+
+void indicator_cache::update_size(const std::string& symbol, const indicator_series& entry) {
+    // Sized outside the cache lock; the caller holds the entry's own lock
+    const std::size_t bytes = entry.memory_bytes();
+    std::string key = cache_key(symbol, entry.spec);
+    std::lock_guard lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end() || it->second->entry.get() != &entry) {
+        return; // evicted or replaced meanwhile
+    }
+    bytes_ = bytes_ - it->second->bytes + bytes;
+    it->second->bytes = bytes;
+    evict_locked(&*it->second);
+}
+
+void indicator_cache::evict_locked(const node* keep) {
+    auto it = lru_.end();
+    while (bytes_ > capacity_ && it != lru_.begin()) {
+        --it;
+        if (&*it == keep) {
+            continue;
+        }
+        bytes_ -= it->bytes;
+        index_.erase(it->key);
+        it = lru_.erase(it);
+    }
+}
+
+std::size_t indicator_cache::size() const {
+    std::lock_guard lock(mutex_);
+    return lru_.size();
+}
+
+std::size_t indicator_cache::memory_bytes() const {
+    std::lock_guard lock(mutex_);
+    return bytes_;
+}
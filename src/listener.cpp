@@ -4,8 +4,11 @@ listener::listener(
     net::io_context& ioc,
     tcp::endpoint endpoint,
     std::shared_ptr<std::string const> const& doc_root,
-    std::shared_ptr<IDatabase> db )
-    : ioc_(ioc),  acceptor_(net::make_strand(ioc)), doc_root_(doc_root),db_(db)
+    std::shared_ptr<IDatabase> db,
+    bool per_core)
+    : ioc_(ioc),
+      acceptor_(per_core ? tcp::acceptor(ioc) : tcp::acceptor(net::make_strand(ioc))),
+      doc_root_(doc_root), db_(db), per_core_(per_core)
 {
     beast::error_code ec;
 
@@ -21,6 +24,18 @@ listener::listener(
         return;
     }
 
+    if (per_core_) {
+#ifdef SO_REUSEPORT
+        acceptor_.set_option(net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true), ec);
+#else
+        ec = net::error::operation_not_supported;
+#endif
+        if (ec) {
+            fail(ec, "set_option SO_REUSEPORT");
+            return;
+        }
+    }
+
     // Bind to the server address
     acceptor_.bind(endpoint, ec);
     if (ec) {
@@ -41,14 +56,24 @@ void listener::run() {
 }
 
 void listener::do_accept() {
+    if (per_core_) {
+        // The io_context has a single thread; sessions need no strand
+        acceptor_.async_accept(
+            ioc_.get_executor(),
+            beast::bind_front_handler(
+                &listener::on_accept<core_session>,
+                shared_from_this()));
+        return;
+    }
     acceptor_.async_accept(
         net::make_strand(ioc_),
         beast::bind_front_handler(
-            &listener::on_accept,
+            &listener::on_accept<session>,
             shared_from_this()));
 }
 
-void listener::on_accept(beast::error_code ec, tcp::socket socket) {
+template <class Session>
+void listener::on_accept(beast::error_code ec, typename Session::socket_type socket) {
     if (ec) {
         fail(ec, "accept");
     } else {
@@ -57,9 +82,11 @@ void listener::on_accept(beast::error_code ec, tcp::socket socket) {
         //    std::move(socket),
         //    doc_root_)->run();
 
-        std::make_shared<session>(
+        // Session and control block share one block from the pool
+        std::allocate_shared<Session>(
+            pool_allocator<Session>(),
             std::move(socket),
-            doc_root_, 
+            doc_root_,
             db_)->run();
     }
     do_accept();
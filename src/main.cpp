@@ -1,5 +1,6 @@
 #include <boost/asio.hpp>
 #include <boost/program_options.hpp>
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
@@ -13,6 +14,11 @@
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include <nlohmann/json.hpp> 
 #include "CustomFormatter.hpp" 
+#include "symbol_store.hpp"
+#include "compute_pool.hpp"
+#include "data_watcher.hpp"
+#include "indicators.hpp"
+#include "cpu_affinity.hpp"
 
 using json = nlohmann::json;
 namespace net = boost::asio;
@@ -35,7 +41,8 @@ int main(int argc, char *argv[])
             ("host", po::value<std::string>(), "host address to bind to")
             ("port", po::value<unsigned short>(), "port to expose to")
             ("doc_root", po::value<std::string>(), "root directory to serve")
-            ("threads", po::value<unsigned short>(), "number of threads to use");
+            ("threads", po::value<unsigned short>(), "number of threads to use")
+            ("io_mode", po::value<std::string>(), "shared or per_core io_context");
 
         po::variables_map args;
         po::store(po::parse_command_line(argc, argv, desc), args);
@@ -53,11 +60,56 @@ int main(int argc, char *argv[])
         unsigned short port = args.count("port") ? args["port"].as<unsigned short>() : 8080;
         std::string doc_root = args.count("doc_root") ? args["doc_root"].as<std::string>() : "/var/www/";
         unsigned short threads = args.count("threads") ? args["threads"].as<unsigned short>() : 1;
+        std::string io_mode = args.count("io_mode") ? args["io_mode"].as<std::string>() : config.io_mode;
+        if (io_mode != "shared" && io_mode != "per_core")
+        {
+            spdlog::critical("Unknown io_mode '{}', expected shared or per_core", io_mode);
+            return EXIT_FAILURE;
+        }
+        const bool per_core = io_mode == "per_core";
 
-        spdlog::info("Server Configuration - Host: {}, Port: {}, Document Root: {}, Threads: {}", host, port, doc_root, threads);
+        // per_core runs one io thread per CPU unless told otherwise
+        std::vector<int> cpus = allowed_cpus();
+        if (per_core && !args.count("threads"))
+        {
+            threads = static_cast<unsigned short>(cpus.size());
+        }
+        threads = std::max<unsigned short>(threads, 1);
+
+        spdlog::info("Server Configuration - Host: {}, Port: {}, Document Root: {}, Threads: {}, IO mode: {}", host, port, doc_root, threads, io_mode);
+
+        compute_pool::set_thread_count(config.compute_threads);
+
+        // Parse the price files once so requests are served from memory
+        symbol_store& store = symbol_store::getInstance();
+        store.set_data_root(config.data_root);
+        store.set_snapshot_root(config.snapshot_root);
+        store.set_verify_snapshots(config.snapshot_verify);
+        store.set_capacity_bytes(config.symbol_cache_mb << 20);
+        std::size_t symbol_count = store.load_all();
+        std::size_t cataloged = 0;
+        store.catalog({}, {}, 0, &cataloged);
+        spdlog::info("Loaded {} of {} symbols from {}", symbol_count, cataloged, config.data_root);
+
+        indicator_cache::getInstance().set_capacity_bytes(config.indicator_cache_mb << 20);
+
+        // Initialize Boost.Asio I/O contexts: one shared by every io thread,
+        // or in per_core mode one per thread, so a connection stays on the
+        // thread that accepted it and threads share no scheduler queue
+        std::vector<std::unique_ptr<net::io_context>> contexts;
+        for (unsigned short i = 0; i < (per_core ? threads : 1); ++i)
+        {
+            contexts.push_back(std::make_unique<net::io_context>(per_core ? 1 : threads));
+        }
+        net::io_context& ioc = *contexts.front();
 
-        // Initialize Boost.Asio I/O context
-        net::io_context ioc{threads};
+        if (config.watch_data) {
+            try {
+                std::make_shared<data_watcher>(ioc, store)->run();
+            } catch (const std::exception& e) {
+                spdlog::warn("Not watching {} for changes: {}", config.data_root, e.what());
+            }
+        }
 
         std::string connStr = "dbname=" + config.database_name +
                                " user=" + config.database_user +
@@ -69,29 +121,44 @@ int main(int argc, char *argv[])
 
         auto db = std::make_shared<PostgresDatabase>(connStr);
 
-        // Create and launch a listening port
-        std::make_shared<listener>(
-            ioc,
-            tcp::endpoint{net::ip::make_address(host), port},
-            std::make_shared<std::string>(doc_root),
-            db)
-            ->run();
+        // Create and launch a listening port; per_core binds one listener
+        // per io_context to the same port with SO_REUSEPORT
+        auto doc_root_ptr = std::make_shared<std::string>(doc_root);
+        for (auto& context : contexts)
+        {
+            std::make_shared<listener>(
+                *context,
+                tcp::endpoint{net::ip::make_address(host), port},
+                doc_root_ptr,
+                db,
+                per_core)
+                ->run();
+        }
 
-        spdlog::info("Listener started on {}:{}", host, port);
+        spdlog::info("{} listener(s) started on {}:{}", contexts.size(), host, port);
+
+        auto run_io = [&](std::size_t i)
+        {
+            if (per_core && config.pin_threads)
+            {
+                int cpu = cpus[i % cpus.size()];
+                if (!pin_current_thread(cpu))
+                {
+                    spdlog::warn("Could not pin IO thread {} to CPU {}", i, cpu);
+                }
+            }
+            (per_core ? *contexts[i] : ioc).run();
+        };
 
         std::vector<std::thread> v;
         v.reserve(threads - 1);
         for (auto i = threads - 1; i > 0; --i)
         {
-            v.emplace_back(
-                [&ioc]
-                {
-                    ioc.run();
-                });
+            v.emplace_back(run_io, i);
         }
         spdlog::info("Main thread running IO context");
 
-        ioc.run();
+        run_io(0);
         spdlog::info("Application shutting down");
 
         // Join all threads
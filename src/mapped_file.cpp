@@ -0,0 +1,74 @@
+// mapped_file.cpp
+#include "mapped_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+mapped_file::mapped_file(const std::string& path, access_hint hint)
+    : path_(path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + path + " (" + std::strerror(errno) + ")");
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("Failed to stat file: " + path + " (" + std::strerror(err) + ")");
+    }
+
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0) {
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            int err = errno;
+            ::close(fd);
+            throw std::runtime_error("Failed to map file: " + path + " (" + std::strerror(err) + ")");
+        }
+        // The parsers walk the mapping front to back exactly once; snapshots
+        // are read in ranges and keep the kernel default
+        if (hint == access_hint::sequential) {
+            ::madvise(addr, size_, MADV_SEQUENTIAL);
+        }
+        data_ = static_cast<const char*>(addr);
+    }
+
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+}
+
+mapped_file::~mapped_file() {
+    release();
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : path_(std::move(other.path_)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0))
+{
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+        release();
+        path_ = std::move(other.path_);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+void mapped_file::release() noexcept {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
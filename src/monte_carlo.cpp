@@ -0,0 +1,205 @@
+// monte_carlo.cpp
+#include "monte_carlo.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "compute_pool.hpp"
+#include "date_utils.hpp"
+
+namespace {
+
+// Paths per parallel_for task
+constexpr std::size_t path_chunk = 4096;
+
+// Counter word 3 keeps the methods' streams apart
+constexpr std::uint32_t bootstrap_stream = 0;
+constexpr std::uint32_t gbm_stream = 1;
+
+philox4x32::block path_counter(std::size_t path, std::size_t block, std::uint32_t stream) {
+    const std::uint64_t p = path;
+    return {static_cast<std::uint32_t>(block), static_cast<std::uint32_t>(p), static_cast<std::uint32_t>(p >> 32), stream};
+}
+
+// Uniform in (0, 1] from 64 random bits
+double unit_interval(std::uint32_t hi, std::uint32_t lo) {
+    const std::uint64_t bits = (std::uint64_t{hi} << 32) | lo;
+    return (static_cast<double>(bits >> 11) + 1.0) * 0x1.0p-53;
+}
+
+struct path_outcome {
+    float terminal;
+    float max_drawdown;
+};
+
+// growth holds 1 + r for each historical return
+path_outcome bootstrap_path(const std::vector<double>& growth, std::size_t horizon, std::uint64_t seed,
+                            std::size_t path) {
+    const std::uint64_t n = growth.size();
+    double value = 1.0;
+    double peak = 1.0;
+    double drawdown = 0.0;
+    philox4x32::block bits{};
+    for (std::size_t s = 0; s < horizon; ++s) {
+        if (s % 4 == 0) {
+            bits = philox4x32::generate(seed, path_counter(path, s / 4, bootstrap_stream));
+        }
+        // Multiply-shift maps 32 random bits onto [0, n)
+        value *= growth[static_cast<std::size_t>((bits[s % 4] * n) >> 32)];
+        peak = std::max(peak, value);
+        drawdown = std::min(drawdown, value / peak - 1.0);
+    }
+    return {static_cast<float>(value), static_cast<float>(drawdown)};
+}
+
+// Works in log space: one exp per path instead of one per step
+path_outcome gbm_path(double drift, double volatility, std::size_t horizon, std::uint64_t seed, std::size_t path) {
+    constexpr double two_pi = 6.283185307179586;
+    double log_value = 0.0;
+    double log_peak = 0.0;
+    double log_drawdown = 0.0;
+    double z[2] = {0.0, 0.0};
+    for (std::size_t s = 0; s < horizon; ++s) {
+        if (s % 2 == 0) {
+            // Box-Muller: two normals per block
+            const philox4x32::block bits = philox4x32::generate(seed, path_counter(path, s / 2, gbm_stream));
+            const double r = std::sqrt(-2.0 * std::log(unit_interval(bits[0], bits[1])));
+            const double theta = two_pi * unit_interval(bits[2], bits[3]);
+            z[0] = r * std::cos(theta);
+            z[1] = r * std::sin(theta);
+        }
+        log_value += drift + volatility * z[s % 2];
+        log_peak = std::max(log_peak, log_value);
+        log_drawdown = std::min(log_drawdown, log_value - log_peak);
+    }
+    return {static_cast<float>(std::exp(log_value)), static_cast<float>(std::expm1(log_drawdown))};
+}
+
+// Mean and quantiles of values; reorders values
+simulation_quantiles quantiles_of(std::vector<float>& values) {
+    simulation_quantiles q;
+    const std::size_t n = values.size();
+    double sum = 0.0;
+    for (float v : values) {
+        sum += v;
+    }
+    q.mean = sum / static_cast<double>(n);
+
+    // Ascending ranks, each selected within what is left of the previous one
+    const double levels[] = {0.05, 0.25, 0.50, 0.75, 0.95};
+    double* outs[] = {&q.p5, &q.p25, &q.p50, &q.p75, &q.p95};
+    auto first = values.begin();
+    for (std::size_t i = 0; i < std::size(levels); ++i) {
+        auto nth = values.begin() + static_cast<std::ptrdiff_t>(levels[i] * static_cast<double>(n - 1) + 0.5);
+        std::nth_element(first, nth, values.end());
+        *outs[i] = *nth;
+        first = nth;
+    }
+    return q;
+}
+
+void write_quantiles(json_writer& w, const simulation_quantiles& q) {
+    w.begin_object();
+    w.key("mean").value(q.mean);
+    w.key("p25").value(q.p25);
+    w.key("p5").value(q.p5);
+    w.key("p50").value(q.p50);
+    w.key("p75").value(q.p75);
+    w.key("p95").value(q.p95);
+    w.end_object();
+}
+
+} // namespace
+
+simulation_method parse_simulation_method(std::string_view name) {
+    if (name == "bootstrap") {
+        return simulation_method::bootstrap;
+    }
+    if (name == "gbm") {
+        return simulation_method::gbm;
+    }
+    throw std::invalid_argument("Unknown method: '" + std::string(name) + "'");
+}
+
+const char* simulation_method_name(simulation_method method) noexcept {
+    return method == simulation_method::gbm ? "gbm" : "bootstrap";
+}
+
+simulation_result run_simulation(const price_series& series, row_range range, const simulation_request& request) {
+    if (range.empty() || range.size() < 2) {
+        throw std::invalid_argument("At least two rows of history are needed to simulate");
+    }
+    if (request.paths == 0 || request.paths > simulate_max_paths) {
+        throw std::invalid_argument("paths must be between 1 and " + std::to_string(simulate_max_paths));
+    }
+    if (request.horizon == 0 || request.horizon > simulate_max_horizon) {
+        throw std::invalid_argument("horizon must be between 1 and " + std::to_string(simulate_max_horizon));
+    }
+    if (static_cast<std::uint64_t>(request.paths) * request.horizon > simulate_max_steps) {
+        throw std::invalid_argument("paths x horizon may be at most " + std::to_string(simulate_max_steps));
+    }
+
+    simulation_result result;
+    result.history_returns = range.size() - 1;
+    result.history_first_day = series.day[range.begin];
+    result.history_last_day = series.day[range.end - 1];
+
+    std::vector<double> growth(result.history_returns);
+    double log_sum = 0.0;
+    double log_sum_sq = 0.0;
+    for (std::size_t i = 0; i < growth.size(); ++i) {
+        growth[i] = series.price[range.begin + i + 1] / series.price[range.begin + i];
+        const double l = std::log(growth[i]);
+        log_sum += l;
+        log_sum_sq += l * l;
+    }
+    const double m = static_cast<double>(growth.size());
+    result.daily_drift = log_sum / m;
+    result.daily_volatility = growth.size() > 1
+        ? std::sqrt(std::max(log_sum_sq - log_sum * result.daily_drift, 0.0) / (m - 1.0))
+        : 0.0;
+
+    std::vector<float> terminal(request.paths);
+    std::vector<float> drawdown(request.paths);
+    const std::size_t chunks = (request.paths + path_chunk - 1) / path_chunk;
+    compute_pool::getInstance().parallel_for(chunks, [&](std::size_t c) {
+        const std::size_t end = std::min(request.paths, (c + 1) * path_chunk);
+        for (std::size_t p = c * path_chunk; p < end; ++p) {
+            const path_outcome o = request.method == simulation_method::gbm
+                ? gbm_path(result.daily_drift, result.daily_volatility, request.horizon, request.seed, p)
+                : bootstrap_path(growth, request.horizon, request.seed, p);
+            terminal[p] = o.terminal;
+            drawdown[p] = o.max_drawdown;
+        }
+    });
+
+    const std::size_t losses = static_cast<std::size_t>(
+        std::count_if(terminal.begin(), terminal.end(), [](float v) { return v < 1.0f; }));
+    result.probability_of_loss = static_cast<double>(losses) / static_cast<double>(request.paths);
+    result.terminal = quantiles_of(terminal);
+    result.max_drawdown = quantiles_of(drawdown);
+    return result;
+}
+
+void write_simulation_result(json_writer& w, std::string_view symbol, const simulation_request& request,
+                             const simulation_result& r) {
+    w.begin_object();
+    w.key("history").begin_object()
+        .key("drift").value(r.daily_drift)
+        .key("from").value(format_day(r.history_first_day))
+        .key("returns").value(r.history_returns)
+        .key("to").value(format_day(r.history_last_day))
+        .key("volatility").value(r.daily_volatility)
+        .end_object();
+    w.key("horizon").value(request.horizon);
+    w.key("max_drawdown");
+    write_quantiles(w, r.max_drawdown);
+    w.key("method").value(simulation_method_name(request.method));
+    w.key("paths").value(request.paths);
+    w.key("probability_of_loss").value(r.probability_of_loss);
+    w.key("seed").value(request.seed);
+    w.key("symbol").value(symbol);
+    w.key("terminal");
+    write_quantiles(w, r.terminal);
+    w.end_object();
+}
@@ -0,0 +1,201 @@
+// portfolio_backtest.cpp
+#include "portfolio_backtest.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "compute_pool.hpp"
+#include "date_utils.hpp"
+#include "series_query.hpp"
+#include "series_stats.hpp"
+
+namespace {
+
+// Key shared by the days of one rebalancing period
+std::int32_t period_key(rebalance_period period, std::int32_t day) {
+    switch (period) {
+        case rebalance_period::weekly: return week_number(day);
+        case rebalance_period::monthly: return month_number(day);
+        case rebalance_period::quarterly: {
+            const std::int32_t m = month_number(day);
+            return m >= 0 ? m / 3 : (m - 2) / 3;
+        }
+        case rebalance_period::yearly: return civil_from_days(day).year;
+        default: return 0;
+    }
+}
+
+// Weight vectors per parallel_for task; a single run is a few microseconds,
+// too little to be worth a pool handler of its own
+constexpr std::size_t batch_chunk = 64;
+
+} // namespace
+
+rebalance_period parse_rebalance_period(std::string_view name) {
+    static constexpr std::pair<std::string_view, rebalance_period> names[] = {
+        {"none", rebalance_period::none},
+        {"daily", rebalance_period::daily},
+        {"weekly", rebalance_period::weekly},
+        {"monthly", rebalance_period::monthly},
+        {"quarterly", rebalance_period::quarterly},
+        {"yearly", rebalance_period::yearly},
+    };
+    for (const auto& [n, period] : names) {
+        if (n == name) {
+            return period;
+        }
+    }
+    throw std::invalid_argument("Unknown rebalance period: '" + std::string(name) + "'");
+}
+
+const char* rebalance_period_name(rebalance_period period) noexcept {
+    switch (period) {
+        case rebalance_period::none: return "none";
+        case rebalance_period::daily: return "daily";
+        case rebalance_period::weekly: return "weekly";
+        case rebalance_period::monthly: return "monthly";
+        case rebalance_period::quarterly: return "quarterly";
+        case rebalance_period::yearly: return "yearly";
+    }
+    return "none";
+}
+
+backtest_universe::backtest_universe(const std::vector<std::shared_ptr<const price_series>>& series,
+                                     std::optional<std::int32_t> from,
+                                     std::optional<std::int32_t> to,
+                                     rebalance_period period)
+    : days_(common_days(series, from, to)), period_(period)
+{
+    if (series.empty()) {
+        throw std::invalid_argument("A backtest needs at least one symbol");
+    }
+    if (days_.size() < 2) {
+        throw std::invalid_argument("The symbols share fewer than two dates in the window");
+    }
+
+    const std::size_t n = series.size();
+    const std::size_t rows = days_.size() - 1;
+    symbols_.reserve(n);
+    for (const auto& s : series) {
+        symbols_.push_back(s->symbol);
+    }
+
+    growth_.resize(rows * n);
+    std::vector<double> prices(days_.size());
+    for (std::size_t s = 0; s < n; ++s) {
+        gather_prices(*series[s], days_, prices.data());
+        for (std::size_t d = 0; d < rows; ++d) {
+            growth_[d * n + s] = prices[d + 1] / prices[d];
+        }
+    }
+
+    rebalance_.resize(rows);
+    for (std::size_t d = 0; d < rows; ++d) {
+        rebalance_[d] = period == rebalance_period::daily ||
+                        (period != rebalance_period::none &&
+                         period_key(period, days_[d + 1]) != period_key(period, days_[d]));
+    }
+}
+
+std::vector<double> backtest_universe::normalize(const std::vector<double>& weights) const {
+    if (weights.size() != symbols()) {
+        throw std::invalid_argument("Expected " + std::to_string(symbols()) + " weights, got " +
+                                    std::to_string(weights.size()));
+    }
+    double total = 0.0;
+    for (double w : weights) {
+        if (!std::isfinite(w) || w < 0.0) {
+            throw std::invalid_argument("Weights must be finite and not negative");
+        }
+        total += w;
+    }
+    if (total <= 0.0) {
+        throw std::invalid_argument("Weights must not all be zero");
+    }
+    std::vector<double> out(weights.size());
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        out[i] = weights[i] / total;
+    }
+    return out;
+}
+
+backtest_summary backtest_universe::run(const double* weights, double risk_free, std::vector<double>* equity) const {
+    const std::size_t n = symbols();
+    const std::size_t rows = days_.size() - 1;
+
+    thread_local std::vector<double> holdings;
+    holdings.assign(weights, weights + n);
+    if (equity) {
+        equity->resize(days_.size());
+        (*equity)[0] = 1.0;
+    }
+
+    double value = 1.0;
+    double peak = 1.0;
+    double max_drawdown = 0.0;
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    const double* g = growth_.data();
+    for (std::size_t d = 0; d < rows; ++d, g += n) {
+        double next = 0.0;
+        for (std::size_t s = 0; s < n; ++s) {
+            holdings[s] *= g[s];
+            next += holdings[s];
+        }
+        const double r = next / value - 1.0;
+        sum += r;
+        sum_sq += r * r;
+        value = next;
+        peak = std::max(peak, value);
+        max_drawdown = std::min(max_drawdown, value / peak - 1.0);
+        if (rebalance_[d]) {
+            for (std::size_t s = 0; s < n; ++s) {
+                holdings[s] = value * weights[s];
+            }
+        }
+        if (equity) {
+            (*equity)[d + 1] = value;
+        }
+    }
+
+    const double count = static_cast<double>(rows);
+    const double mean = sum / count;
+    const double stddev = rows > 1 ? std::sqrt(std::max(sum_sq - sum * mean, 0.0) / (count - 1.0)) : 0.0;
+
+    backtest_summary out;
+    out.total_return = value - 1.0;
+    out.cagr = std::pow(value, trading_days_per_year / count) - 1.0;
+    out.volatility = stddev * std::sqrt(trading_days_per_year);
+    out.sharpe = stddev > 0.0
+        ? (mean - risk_free / trading_days_per_year) / stddev * std::sqrt(trading_days_per_year)
+        : std::numeric_limits<double>::quiet_NaN();
+    out.max_drawdown = max_drawdown;
+    return out;
+}
+
+std::vector<backtest_summary> backtest_universe::run_batch(const std::vector<double>& weights, std::size_t count,
+                                                           double risk_free) const {
+    const std::size_t n = symbols();
+    if (weights.size() != count * n) {
+        throw std::invalid_argument("Weight matrix does not match the symbol count");
+    }
+    std::vector<backtest_summary> out(count);
+    const std::size_t chunks = (count + batch_chunk - 1) / batch_chunk;
+    compute_pool::getInstance().parallel_for(chunks, [&](std::size_t c) {
+        const std::size_t end = std::min(count, (c + 1) * batch_chunk);
+        for (std::size_t i = c * batch_chunk; i < end; ++i) {
+            out[i] = run(weights.data() + i * n, risk_free);
+        }
+    });
+    return out;
+}
+
+void write_backtest_summary(json_writer& w, const backtest_summary& s) {
+    w.begin_object();
+    w.key("cagr").value(s.cagr);
+    w.key("max_drawdown").value(s.max_drawdown);
+    w.key("sharpe").value(s.sharpe);
+    w.key("total_return").value(s.total_return);
+    w.key("volatility").value(s.volatility);
+    w.end_object();
+}
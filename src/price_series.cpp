@@ -0,0 +1,248 @@
+// price_series.cpp
+#include "price_series.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include "spdlog/spdlog.h"
+#include "compute_pool.hpp"
+#include "csv_parser.hpp"
+#include "date_utils.hpp"
+#include "mapped_file.hpp"
+
+void price_series::push_back(const price_record& record) {
+    day.push_back(record.day);
+    price.push_back(record.price);
+    open.push_back(record.open);
+    high.push_back(record.high);
+    low.push_back(record.low);
+    volume.push_back(record.volume);
+    change_percent.push_back(record.change_percent);
+}
+
+void price_series::reserve(std::size_t rows) {
+    day.reserve(rows);
+    price.reserve(rows);
+    open.reserve(rows);
+    high.reserve(rows);
+    low.reserve(rows);
+    volume.reserve(rows);
+    change_percent.reserve(rows);
+}
+
+StockPrice price_series::row(std::size_t i) const {
+    StockPrice stock;
+    stock.Date = format_day(day[i]);
+    stock.Price = price[i];
+    stock.Open = open[i];
+    stock.High = high[i];
+    stock.Low = low[i];
+    stock.Volume = format_volume(volume[i]);
+    stock.ChangePercent = change_percent[i];
+    return stock;
+}
+
+std::size_t price_series::memory_bytes() const noexcept {
+    return sizeof(*this) + symbol.capacity() + day.capacity_bytes() + price.capacity_bytes() +
+           open.capacity_bytes() + high.capacity_bytes() + low.capacity_bytes() +
+           volume.capacity_bytes() + change_percent.capacity_bytes();
+}
+
+double parse_volume(std::string_view text) {
+    if (text.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    double scale = 1.0;
+    switch (text.back()) {
+        case 'K': scale = 1e3; break;
+        case 'M': scale = 1e6; break;
+        case 'B': scale = 1e9; break;
+        default: break;
+    }
+    if (scale != 1.0) {
+        text.remove_suffix(1);
+    }
+    return csv_to_double(text) * scale;
+}
+
+void csv_day::parse(std::string_view field, std::int32_t& out) {
+    out = parse_day(field);
+}
+
+std::string format_volume(double volume) {
+    if (std::isnan(volume)) {
+        return {};
+    }
+    char suffix = '\0';
+    double scaled = volume;
+    if (volume >= 1e9) {
+        suffix = 'B';
+        scaled = volume / 1e9;
+    } else if (volume >= 1e6) {
+        suffix = 'M';
+        scaled = volume / 1e6;
+    } else if (volume >= 1e3) {
+        suffix = 'K';
+        scaled = volume / 1e3;
+    }
+    char buf[32];
+    int n = suffix ? std::snprintf(buf, sizeof(buf), "%.2f%c", scaled, suffix)
+                   : std::snprintf(buf, sizeof(buf), "%.2f", scaled);
+    return std::string(buf, static_cast<std::size_t>(n));
+}
+
+namespace {
+
+template <class T>
+void apply_permutation(series_column<T>& column, const std::vector<std::size_t>& order) {
+    std::vector<T> sorted;
+    sorted.reserve(column.size());
+    for (std::size_t i : order) {
+        sorted.push_back(column[i]);
+    }
+    column.values().swap(sorted);
+}
+
+// Exported price files are newest first; store rows oldest first
+void sort_by_day(price_series& s) {
+    const auto& d = s.day;
+    if (std::is_sorted(d.begin(), d.end())) {
+        return;
+    }
+    if (std::is_sorted(d.begin(), d.end(), std::greater<>())) {
+        for (auto* col : {&s.price, &s.open, &s.high, &s.low, &s.volume, &s.change_percent}) {
+            std::reverse(col->values().begin(), col->values().end());
+        }
+        std::reverse(s.day.values().begin(), s.day.values().end());
+        return;
+    }
+    std::vector<std::size_t> order(d.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&d](std::size_t a, std::size_t b) { return d[a] < d[b]; });
+    apply_permutation(s.day, order);
+    for (auto* col : {&s.price, &s.open, &s.high, &s.low, &s.volume, &s.change_percent}) {
+        apply_permutation(*col, order);
+    }
+}
+
+// Appends every record of reader to s
+void append_rows(csv_reader& reader, const csv_binder<price_record>& bind, price_series& s,
+                 const std::string& file_path) {
+    csv_row row;
+    while (reader.next(row)) {
+        try {
+            s.push_back(bind(row));
+        } catch (const std::exception& e) {
+            throw std::runtime_error(file_path + ": " + e.what());
+        }
+    }
+}
+
+std::size_t count_lines(std::string_view text) {
+    return static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n')) + 1;
+}
+
+template <class T>
+void append_column(series_column<T>& to, const series_column<T>& from) {
+    std::vector<T>& values = to.values();
+    values.insert(values.end(), from.begin(), from.end());
+}
+
+} // namespace
+
+std::uint64_t csv_fingerprint(std::string_view file, std::size_t bytes) {
+    // Enough trailing bytes to hold the last few rows before the offset
+    constexpr std::size_t tail_bytes = 4096;
+    std::string_view prefix = file.substr(0, bytes);
+    std::string_view header = prefix.substr(0, prefix.find('\n'));
+    std::string_view tail = prefix.substr(prefix.size() - std::min(prefix.size(), tail_bytes));
+    const std::hash<std::string_view> hash;
+    std::uint64_t h = hash(header);
+    h ^= hash(tail) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h ^ prefix.size();
+}
+
+csv_extent csv_extent_of(std::string_view file, std::size_t bytes) {
+    csv_extent extent;
+    extent.bytes = bytes;
+    std::size_t end = file.substr(0, bytes).rfind('\n');
+    extent.lines = end == std::string_view::npos ? 0 : end + 1;
+    extent.fingerprint = csv_fingerprint(file, bytes);
+    return extent;
+}
+
+price_series load_price_series(const std::string& symbol, const std::string& file_path,
+                               csv_extent* extent) {
+    mapped_file file(file_path);
+    if (extent) {
+        *extent = csv_extent_of(file.view(), file.size());
+    }
+    csv_reader reader(file.view());
+    const csv_binder<price_record> bind(reader.header());
+
+    price_series s;
+    s.symbol = symbol;
+
+    compute_pool& pool = compute_pool::getInstance();
+    std::vector<std::string_view> chunks = csv_split_chunks(reader.remaining(), pool.concurrency());
+
+    if (chunks.size() > 1) {
+        // Large file: parse newline-aligned chunks on the compute pool, then
+        // concatenate the partial columns in file order
+        std::vector<price_series> parts(chunks.size());
+        try {
+            pool.parallel_for(chunks.size(), [&](std::size_t i) {
+                csv_reader chunk(chunks[i], reader.header());
+                parts[i].reserve(count_lines(chunks[i]));
+                append_rows(chunk, bind, parts[i], file_path);
+            });
+
+            std::size_t total = 0;
+            for (const auto& part : parts) {
+                total += part.size();
+            }
+            s.reserve(total);
+            for (const auto& part : parts) {
+                append_column(s.day, part.day);
+                append_column(s.price, part.price);
+                append_column(s.open, part.open);
+                append_column(s.high, part.high);
+                append_column(s.low, part.low);
+                append_column(s.volume, part.volume);
+                append_column(s.change_percent, part.change_percent);
+            }
+            sort_by_day(s);
+            return s;
+        } catch (const std::exception& e) {
+            // A chunk boundary inside a quoted field, or a genuinely bad row;
+            // the serial pass below either recovers or reports the right line
+            spdlog::debug("Parallel parse of {} failed ({}), retrying serially", file_path, e.what());
+        }
+    }
+
+    csv_reader serial(file.view());
+    s.reserve(count_lines(serial.remaining()));
+    append_rows(serial, bind, s, file_path);
+    sort_by_day(s);
+    return s;
+}
+
+std::size_t append_price_rows(price_series& s, const std::vector<std::string_view>& header,
+                              std::string_view records, const std::string& file_path) {
+    csv_reader reader(records, header);
+    const csv_binder<price_record> bind(header);
+    const std::size_t before = s.size();
+    s.reserve(before + count_lines(records));
+    append_rows(reader, bind, s, file_path);
+
+    // Appended rows are normally later than everything already loaded, in
+    // which case only the new tail needs checking
+    const auto& d = s.day;
+    if (!std::is_sorted(d.begin() + (before > 0 ? before - 1 : 0), d.end())) {
+        sort_by_day(s);
+    }
+    return s.size() - before;
+}
@@ -0,0 +1,222 @@
+// range_index.cpp
+#include "range_index.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "compute_pool.hpp"
+
+namespace {
+
+constexpr series_field indexed_columns[] = {
+    field_price, field_open, field_high, field_low, field_change_percent};
+
+// floor(log2(n)) for n >= 1
+unsigned floor_log2(std::size_t n) {
+    unsigned k = 0;
+    while (n >>= 1) {
+        ++k;
+    }
+    return k;
+}
+
+} // namespace
+
+int range_index::slot_of(series_field column) noexcept {
+    for (int i = 0; i < static_cast<int>(std::size(indexed_columns)); ++i) {
+        if (indexed_columns[i] == column) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const series_column<double>* range_index::column_of(const price_series& series, series_field column) noexcept {
+    switch (column) {
+        case field_price: return &series.price;
+        case field_open: return &series.open;
+        case field_high: return &series.high;
+        case field_low: return &series.low;
+        case field_change_percent: return &series.change_percent;
+        default: return nullptr;
+    }
+}
+
+range_index::range_index(const price_series& series) {
+    compute_pool::getInstance().parallel_for(columns_.size(), [&](std::size_t i) {
+        build(columns_[i], *column_of(series, indexed_columns[i]));
+    });
+}
+
+void range_index::build(column_index& index, const series_column<double>& values) {
+    const std::size_t n = values.size();
+
+    double total = 0.0;
+    for (double x : values) {
+        total += x;
+    }
+    index.shift = n ? total / static_cast<double>(n) : 0.0;
+
+    index.sum.resize(n + 1);
+    index.sum_sq.resize(n + 1);
+    index.sum[0] = 0.0;
+    index.sum_sq[0] = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const double d = values[i] - index.shift;
+        index.sum[i + 1] = index.sum[i] + d;
+        index.sum_sq[i + 1] = index.sum_sq[i] + d * d;
+    }
+
+    const std::size_t blocks = (n + block_size - 1) / block_size;
+    if (blocks == 0) {
+        return;
+    }
+    const unsigned levels = floor_log2(blocks) + 1;
+    index.min_table.assign(levels, {});
+    index.max_table.assign(levels, {});
+    index.min_table[0].resize(blocks);
+    index.max_table[0].resize(blocks);
+    for (std::size_t b = 0; b < blocks; ++b) {
+        const double* first = values.data() + b * block_size;
+        const double* last = values.data() + std::min(n, (b + 1) * block_size);
+        auto [lo, hi] = std::minmax_element(first, last);
+        index.min_table[0][b] = *lo;
+        index.max_table[0][b] = *hi;
+    }
+    for (unsigned k = 1; k < levels; ++k) {
+        const std::size_t span = std::size_t{1} << (k - 1);
+        const std::size_t count = blocks - (std::size_t{1} << k) + 1;
+        const auto& prev_min = index.min_table[k - 1];
+        const auto& prev_max = index.max_table[k - 1];
+        auto& cur_min = index.min_table[k];
+        auto& cur_max = index.max_table[k];
+        cur_min.resize(count);
+        cur_max.resize(count);
+        for (std::size_t b = 0; b < count; ++b) {
+            cur_min[b] = std::min(prev_min[b], prev_min[b + span]);
+            cur_max[b] = std::max(prev_max[b], prev_max[b + span]);
+        }
+    }
+}
+
+range_aggregate range_index::aggregate(const price_series& series, series_field column, row_range range) const {
+    const int slot = slot_of(column);
+    if (slot < 0) {
+        throw std::invalid_argument("Column is not indexed");
+    }
+    const column_index& index = columns_[static_cast<std::size_t>(slot)];
+    const series_column<double>& values = *column_of(series, column);
+    if (index.sum.size() != values.size() + 1 || range.end > values.size()) {
+        throw std::logic_error("range_index used with a different series");
+    }
+
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+    range_aggregate a;
+    a.count = range.empty() ? 0 : range.size();
+    if (a.count == 0) {
+        a.mean = a.variance = a.min = a.max = nan;
+        return a;
+    }
+
+    const double n = static_cast<double>(a.count);
+    const double s = index.sum[range.end] - index.sum[range.begin];
+    const double q = index.sum_sq[range.end] - index.sum_sq[range.begin];
+    a.sum = s + index.shift * n;
+    a.mean = index.shift + s / n;
+    a.variance = a.count > 1 ? std::max((q - s * s / n) / (n - 1.0), 0.0) : nan;
+
+    // Partial blocks at either end are scanned; whole blocks in between come
+    // from two overlapping sparse-table entries
+    const std::size_t first_block = range.begin / block_size;
+    const std::size_t last_block = (range.end - 1) / block_size;
+    const double* data = values.data();
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -lo;
+    auto scan = [&](std::size_t from, std::size_t to) {
+        for (std::size_t i = from; i < to; ++i) {
+            lo = std::min(lo, data[i]);
+            hi = std::max(hi, data[i]);
+        }
+    };
+    if (first_block == last_block) {
+        scan(range.begin, range.end);
+    } else {
+        scan(range.begin, (first_block + 1) * block_size);
+        scan(last_block * block_size, range.end);
+        if (first_block + 1 < last_block) {
+            const std::size_t b0 = first_block + 1;
+            const std::size_t count = last_block - b0;
+            const unsigned k = floor_log2(count);
+            const std::size_t b1 = last_block - (std::size_t{1} << k);
+            lo = std::min({lo, index.min_table[k][b0], index.min_table[k][b1]});
+            hi = std::max({hi, index.max_table[k][b0], index.max_table[k][b1]});
+        }
+    }
+    a.min = lo;
+    a.max = hi;
+    return a;
+}
+
+std::size_t range_index::memory_bytes() const noexcept {
+    std::size_t bytes = sizeof(*this);
+    for (const auto& c : columns_) {
+        bytes += (c.sum.capacity() + c.sum_sq.capacity()) * sizeof(double);
+        for (const auto& level : c.min_table) {
+            bytes += level.capacity() * sizeof(double);
+        }
+        for (const auto& level : c.max_table) {
+            bytes += level.capacity() * sizeof(double);
+        }
+    }
+    return bytes;
+}
+
+range_aggregate scan_range_aggregate(const series_column<double>& values, row_range range) {
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+    range_aggregate a;
+    a.count = range.empty() ? 0 : range.size();
+    if (a.count == 0) {
+        a.mean = a.variance = a.min = a.max = nan;
+        return a;
+    }
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -lo;
+    for (std::size_t i = range.begin; i < range.end; ++i) {
+        a.sum += values[i];
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+    }
+    const double n = static_cast<double>(a.count);
+    a.mean = a.sum / n;
+    double q = 0.0;
+    for (std::size_t i = range.begin; i < range.end; ++i) {
+        q += (values[i] - a.mean) * (values[i] - a.mean);
+    }
+    a.variance = a.count > 1 ? q / (n - 1.0) : nan;
+    a.min = lo;
+    a.max = hi;
+    return a;
+}
+
+range_aggregate aggregate_range(const price_series& series, series_field column, row_range range) {
+    if (series.index) {
+        return series.index->aggregate(series, column, range);
+    }
+    const series_column<double>* values = range_index::column_of(series, column);
+    if (!values || !(range_index::indexed_fields & column)) {
+        throw std::invalid_argument("Column is not indexed");
+    }
+    return scan_range_aggregate(*values, range);
+}
+
+void write_range_aggregate(json_writer& w, const range_aggregate& a) {
+    w.begin_object();
+    w.key("count").value(a.count);
+    w.key("max").value(a.max);
+    w.key("mean").value(a.mean);
+    w.key("min").value(a.min);
+    w.key("stddev").value(std::sqrt(a.variance));
+    w.key("sum").value(a.sum);
+    w.key("variance").value(a.variance);
+    w.end_object();
+}
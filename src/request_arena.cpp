@@ -0,0 +1,71 @@
+// request_arena.cpp
+#include "request_arena.hpp"
+#include <algorithm>
+#include <new>
+
+// Header of an allocation that did not fit the block
+struct request_arena::spill {
+    spill* next;
+    std::size_t alignment;
+};
+
+namespace {
+
+std::size_t align_up(std::size_t n, std::size_t alignment) {
+    return (n + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+request_arena::request_arena(std::size_t bytes)
+    : block_(new std::byte[bytes]), capacity_(bytes)
+{
+}
+
+request_arena::~request_arena() {
+    release_spills();
+}
+
+void* request_arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    auto base = reinterpret_cast<std::uintptr_t>(block_.get());
+    std::size_t offset = align_up(base + used_, alignment) - base;
+    if (offset + bytes <= capacity_) {
+        used_ = offset + bytes;
+        return block_.get() + offset;
+    }
+
+    // Spill: the header sits in front of the allocation, aligned for both
+    alignment = std::max(alignment, alignof(spill));
+    std::size_t header = align_up(sizeof(spill), alignment);
+    void* raw = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                    ? ::operator new(header + bytes, std::align_val_t(alignment))
+                    : ::operator new(header + bytes);
+    spilled_ = new (raw) spill{spilled_, alignment};
+    spilled_bytes_ += bytes;
+    return static_cast<std::byte*>(raw) + header;
+}
+
+void request_arena::release_spills() {
+    while (spilled_) {
+        spill* next = spilled_->next;
+        if (spilled_->alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(spilled_, std::align_val_t(spilled_->alignment));
+        } else {
+            ::operator delete(spilled_);
+        }
+        spilled_ = next;
+    }
+}
+
+void request_arena::reset() {
+    std::size_t high_water = used_ + spilled_bytes_;
+    release_spills();
+    // Grow so a request like the last one fits without spilling
+    if (spilled_bytes_ != 0 && capacity_ < max_block_bytes) {
+        std::size_t bytes = std::min(max_block_bytes, std::max(capacity_ * 2, align_up(high_water + high_water / 4, 1024)));
+        block_.reset(new std::byte[bytes]);
+        capacity_ = bytes;
+    }
+    spilled_bytes_ = 0;
+    used_ = 0;
+}
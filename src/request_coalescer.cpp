@@ -0,0 +1,30 @@
+// request_coalescer.cpp
+#include "request_coalescer.hpp"
+
+single_flight<coalesced_response>& request_coalescer::group(const std::string& route) {
+    std::lock_guard lock(mutex_);
+    auto& slot = routes_[route];
+    if (!slot) {
+        slot = std::make_unique<single_flight<coalesced_response>>();
+    }
+    return *slot;
+}
+
+std::optional<single_flight<coalesced_response>::result> request_coalescer::run(
+    const std::string& route, const std::string& key,
+    const std::function<coalesced_response()>& compute,
+    single_flight<coalesced_response>::waiter wait)
+{
+    // Groups are never removed, so the reference outlives the registry lock
+    return group(route).run(key, compute, std::move(wait));
+}
+
+std::vector<std::pair<std::string, single_flight_stats>> request_coalescer::stats() const {
+    std::lock_guard lock(mutex_);
+    std::vector<std::pair<std::string, single_flight_stats>> out;
+    out.reserve(routes_.size());
+    for (const auto& [route, group] : routes_) {
+        out.emplace_back(route, group->stats());
+    }
+    return out;
+}
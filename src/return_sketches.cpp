@@ -0,0 +1,126 @@
+// return_sketches.cpp
+#include "return_sketches.hpp"
+#include <algorithm>
+#include <cmath>
+#include "date_utils.hpp"
+
+namespace {
+
+void add_values(const price_series& series, std::size_t begin, std::size_t end, tdigest& out) {
+    for (std::size_t i = begin; i < end; ++i) {
+        const double x = series.change_percent[i];
+        if (!std::isnan(x)) {
+            out.add(x);
+        }
+    }
+}
+
+} // namespace
+
+return_sketches::return_sketches(const price_series& series) {
+    build(series, 0);
+}
+
+return_sketches::return_sketches(const price_series& series, const return_sketches& previous,
+                                 std::size_t first_changed)
+{
+    // A year is complete once a later row exists before first_changed; the
+    // year that first_changed falls in (or continues) is rebuilt, along with
+    // every tree sketch that covers it
+    std::size_t kept = 0;
+    while (kept < previous.buckets_.size() && previous.buckets_[kept].end < first_changed) {
+        ++kept;
+    }
+    buckets_.assign(previous.buckets_.begin(), previous.buckets_.begin() + static_cast<std::ptrdiff_t>(kept));
+    for (std::size_t l = 0; l < previous.levels_.size() && (kept >> l) > 0; ++l) {
+        const auto& level = previous.levels_[l];
+        levels_.emplace_back(level.begin(), level.begin() + static_cast<std::ptrdiff_t>(kept >> l));
+    }
+    build(series, buckets_.empty() ? 0 : buckets_.back().end);
+}
+
+void return_sketches::build(const price_series& series, std::size_t first_row) {
+    if (levels_.empty()) {
+        levels_.emplace_back();
+    }
+    const std::size_t n = series.size();
+    std::size_t begin = first_row;
+    while (begin < n) {
+        const int year = civil_from_days(series.day[begin]).year;
+        const std::int32_t next_year = days_from_civil(year + 1, 1, 1);
+        const std::size_t end = static_cast<std::size_t>(
+            std::lower_bound(series.day.begin() + begin, series.day.end(), next_year) - series.day.begin());
+        buckets_.push_back({static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end)});
+        tdigest digest;
+        add_values(series, begin, end, digest);
+        digest.shrink_to_fit();
+        levels_[0].push_back(std::move(digest));
+        begin = end;
+    }
+
+    for (std::size_t l = 1; (buckets_.size() >> l) > 0; ++l) {
+        if (levels_.size() == l) {
+            levels_.emplace_back();
+        }
+        const auto& below = levels_[l - 1];
+        auto& level = levels_[l];
+        for (std::size_t i = level.size(); i < (buckets_.size() >> l); ++i) {
+            tdigest digest;
+            digest.merge(below[2 * i]);
+            digest.merge(below[2 * i + 1]);
+            digest.shrink_to_fit();
+            level.push_back(std::move(digest));
+        }
+    }
+    buckets_.shrink_to_fit();
+}
+
+void return_sketches::add_window(const price_series& series, row_range rows, tdigest& out) const {
+    if (rows.empty()) {
+        return;
+    }
+    // Years [first, last) lie wholly inside rows; the rows of the years
+    // around them are added one by one
+    std::size_t first = static_cast<std::size_t>(
+        std::partition_point(buckets_.begin(), buckets_.end(),
+                             [&](const bucket& b) { return b.begin < rows.begin; }) - buckets_.begin());
+    std::size_t last = static_cast<std::size_t>(
+        std::partition_point(buckets_.begin(), buckets_.end(),
+                             [&](const bucket& b) { return b.end <= rows.end; }) - buckets_.begin());
+    if (first >= last) {
+        add_values(series, rows.begin, rows.end, out);
+        return;
+    }
+    add_values(series, rows.begin, buckets_[first].begin, out);
+    add_values(series, buckets_[last - 1].end, rows.end, out);
+
+    // Bottom-up segment tree walk: take a node whenever the range edge is
+    // not aligned to its parent
+    for (std::size_t l = 0; first < last; ++l, first >>= 1, last >>= 1) {
+        if (first & 1) {
+            out.merge(levels_[l][first++]);
+        }
+        if (last & 1) {
+            out.merge(levels_[l][--last]);
+        }
+    }
+}
+
+std::size_t return_sketches::memory_bytes() const noexcept {
+    std::size_t bytes = buckets_.capacity() * sizeof(bucket);
+    for (const auto& level : levels_) {
+        bytes += level.capacity() * sizeof(tdigest);
+        for (const auto& digest : level) {
+            bytes += digest.memory_bytes();
+        }
+    }
+    return bytes;
+}
+
+void add_change_percents(const price_series& series, row_range rows, tdigest& out) {
+    if (series.sketches) {
+        series.sketches->add_window(series, rows, out);
+    } else if (!rows.empty()) {
+        add_values(series, rows.begin, rows.end, out);
+    }
+}
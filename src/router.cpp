@@ -0,0 +1,268 @@
+// router.cpp
+#include "router.hpp"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace http = boost::beast::http;
+
+static_assert(static_cast<unsigned>(http::verb::unlink) < 64, "method_set has one bit per verb");
+
+struct router::route {
+    route_id id;
+    method_set methods;
+    auth_policy auth;
+    std::vector<std::string> names; // of the pattern's parameters, in order
+};
+
+struct router::node {
+    std::string label;                          // literal edge leading here
+    std::string firsts;                         // first character of each child's label
+    std::vector<std::unique_ptr<node>> children;
+    std::unique_ptr<node> param;                // {name} child, matching one segment
+    std::vector<route> routes;                  // ending here, with disjoint methods
+    std::optional<auth_policy> guard;
+};
+
+router::router() : root_(std::make_unique<node>()) {}
+router::~router() = default;
+router::router(router&&) noexcept = default;
+router& router::operator=(router&&) noexcept = default;
+
+router::node* router::insert_literal(node* at, std::string_view literal) {
+    while (!literal.empty()) {
+        auto pos = at->firsts.find(literal[0]);
+        if (pos == std::string::npos) {
+            auto child = std::make_unique<node>();
+            child->label = std::string(literal);
+            at->firsts.push_back(literal[0]);
+            at->children.push_back(std::move(child));
+            return at->children.back().get();
+        }
+
+        node* child = at->children[pos].get();
+        std::size_t common = std::mismatch(child->label.begin(), child->label.end(),
+                                           literal.begin(), literal.end()).first - child->label.begin();
+        if (common < child->label.size()) {
+            // Split the edge where the literal leaves it
+            auto mid = std::make_unique<node>();
+            mid->label = child->label.substr(0, common);
+            child->label.erase(0, common);
+            mid->firsts.push_back(child->label[0]);
+            mid->children.push_back(std::move(at->children[pos]));
+            at->children[pos] = std::move(mid);
+            child = at->children[pos].get();
+        }
+        literal.remove_prefix(common);
+        at = child;
+    }
+    return at;
+}
+
+void router::add(route_id id, std::string_view pattern, method_set methods, auth_policy auth) {
+    if (pattern.empty() || pattern[0] != '/') {
+        throw std::invalid_argument("route pattern must start with '/': " + std::string(pattern));
+    }
+
+    route r{id, methods, auth, {}};
+    node* at = root_.get();
+    std::string_view rest = pattern;
+    while (!rest.empty()) {
+        auto open = rest.find('{');
+        at = insert_literal(at, rest.substr(0, open));
+        if (open == std::string_view::npos) {
+            break;
+        }
+
+        auto close = rest.find('}', open);
+        bool whole_segment = open > 0 && rest[open - 1] == '/' && close != std::string_view::npos &&
+                             (close + 1 == rest.size() || rest[close + 1] == '/');
+        if (!whole_segment || close == open + 1) {
+            throw std::invalid_argument("route parameter must be a whole named segment: " + std::string(pattern));
+        }
+        if (r.names.size() == max_params) {
+            throw std::invalid_argument("too many route parameters: " + std::string(pattern));
+        }
+        r.names.emplace_back(rest.substr(open + 1, close - open - 1));
+        if (!at->param) {
+            at->param = std::make_unique<node>();
+        }
+        at = at->param.get();
+        rest.remove_prefix(close + 1);
+    }
+
+    for (const route& existing : at->routes) {
+        if (existing.methods & methods) {
+            throw std::invalid_argument("route registered twice: " + std::string(pattern));
+        }
+    }
+    at->routes.push_back(std::move(r));
+}
+
+void router::guard(std::string_view prefix, auth_policy auth) {
+    insert_literal(root_.get(), prefix)->guard = auth;
+}
+
+// Child of at whose label starts with c, if any
+static inline std::size_t child_index(const std::string& firsts, char c) {
+    for (std::size_t i = 0; i < firsts.size(); ++i) {
+        if (firsts[i] == c) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+static inline bool starts_with(std::string_view text, const std::string& prefix) {
+    return text.size() >= prefix.size() && std::memcmp(text.data(), prefix.data(), prefix.size()) == 0;
+}
+
+const router::node* router::find_node(const node* at, std::string_view rest, match& m) const {
+    while (!rest.empty()) {
+        const node* child = nullptr;
+        auto pos = child_index(at->firsts, rest[0]);
+        if (pos != std::string::npos && starts_with(rest, at->children[pos]->label)) {
+            child = at->children[pos].get();
+        }
+
+        if (!at->param || m.param_count == max_params) {
+            // Only the literal edge can match; follow it without recursing
+            if (!child) {
+                return nullptr;
+            }
+            rest.remove_prefix(child->label.size());
+            at = child;
+            continue;
+        }
+
+        // Literal edges win over the parameter; fall back to it on a miss
+        if (child) {
+            std::size_t captured = m.param_count;
+            if (const node* found = find_node(child, rest.substr(child->label.size()), m)) {
+                return found;
+            }
+            m.param_count = captured;
+        }
+        std::string_view segment = rest.substr(0, rest.find('/'));
+        if (segment.empty()) {
+            return nullptr;
+        }
+        m.params[m.param_count++] = segment;
+        rest.remove_prefix(segment.size());
+        at = at->param.get();
+    }
+    return at->routes.empty() ? nullptr : at;
+}
+
+auth_policy router::guard_for(std::string_view path) const {
+    auth_policy auth = auth_policy::none;
+    const node* at = root_.get();
+    while (true) {
+        if (at->guard) {
+            auth = *at->guard;
+        }
+        if (path.empty()) {
+            return auth;
+        }
+        auto pos = child_index(at->firsts, path[0]);
+        if (pos == std::string::npos) {
+            return auth;
+        }
+        const node* child = at->children[pos].get();
+        if (!starts_with(path, child->label)) {
+            return auth;
+        }
+        path.remove_prefix(child->label.size());
+        at = child;
+    }
+}
+
+router::match router::find(http::verb method, std::string_view target) const {
+    match m;
+    auto question = target.find('?');
+    m.path = target.substr(0, question);
+    if (question != std::string_view::npos) {
+        m.query = target.substr(question + 1);
+    }
+
+    const node* at = find_node(root_.get(), m.path, m);
+    if (!at) {
+        m.param_count = 0;
+        m.auth = guard_for(m.path);
+        return m;
+    }
+
+    for (const route& r : at->routes) {
+        if (r.methods & method_bit(method)) {
+            m.result = outcome::matched;
+            m.id = r.id;
+            m.auth = r.auth;
+            m.names_ = &r.names;
+            return m;
+        }
+        m.allow |= r.methods;
+        if (r.auth == auth_policy::jwt) {
+            m.auth = auth_policy::jwt;
+        }
+    }
+    m.result = outcome::method_not_allowed;
+    return m;
+}
+
+std::string_view router::match::param(std::string_view name) const {
+    if (names_) {
+        for (std::size_t i = 0; i < names_->size() && i < param_count; ++i) {
+            if ((*names_)[i] == name) {
+                return params[i];
+            }
+        }
+    }
+    return {};
+}
+
+std::string allow_header(method_set methods) {
+    std::string allow;
+    for (unsigned v = 0; v < 64; ++v) {
+        if (methods & (method_set{1} << v)) {
+            if (!allow.empty()) {
+                allow += ", ";
+            }
+            auto name = http::to_string(static_cast<http::verb>(v));
+            allow.append(name.data(), name.size());
+        }
+    }
+    return allow;
+}
+
+const router& api_router() {
+    static const router instance = [] {
+        // HEAD is answered like GET; the session writes only the header
+        const method_set get = method_bit(http::verb::get) | method_bit(http::verb::head);
+        const method_set post = method_bit(http::verb::post);
+
+        router r;
+        r.add(route_id::login, "/login", post, auth_policy::none);
+        r.add(route_id::hello, "/hello", get, auth_policy::none);
+        r.add(route_id::db, "/db", get, auth_policy::jwt);
+        r.add(route_id::loadcsv, "/loadcsv/{symbol}", get, auth_policy::none);
+        r.add(route_id::connections, "/api/connections", get, auth_policy::jwt);
+        r.add(route_id::coalescing, "/api/coalescing", get, auth_policy::jwt);
+        r.add(route_id::symbols, "/api/symbols", get, auth_policy::jwt);
+        r.add(route_id::stats, "/api/stats/{symbol}", get, auth_policy::jwt);
+        r.add(route_id::range, "/api/range/{symbol}", get, auth_policy::jwt);
+        r.add(route_id::correlation, "/api/correlation", get, auth_policy::jwt);
+        r.add(route_id::quantiles, "/api/quantiles", get, auth_policy::jwt);
+        r.add(route_id::backtest, "/api/backtest", get, auth_policy::jwt);
+        r.add(route_id::backtest_batch, "/api/backtest", post, auth_policy::jwt);
+        r.add(route_id::simulate, "/api/simulate/{symbol}", get, auth_policy::jwt);
+        r.add(route_id::indicators, "/api/indicators/{symbol}", get, auth_policy::jwt);
+
+        // Paths under these that match no route are still not served without a token
+        r.guard("/api", auth_policy::jwt);
+        r.guard("/db", auth_policy::jwt);
+        return r;
+    }();
+    return instance;
+}
@@ -0,0 +1,159 @@
+// series_correlation.cpp
+#include "series_correlation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "compute_pool.hpp"
+#include "date_utils.hpp"
+#include "series_query.hpp"
+
+namespace {
+
+// A tile pairs up to tile_symbols columns with as many others and walks
+// them tile_rows returns at a time, so the 2 x 8 column slices it touches
+// (256 KiB) stay in cache while all 64 products are accumulated
+constexpr std::size_t tile_symbols = 8;
+constexpr std::size_t tile_rows = 2048;
+
+// Four independent accumulators so the loop is not one long dependency chain
+double dot(const double* a, const double* b, std::size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+} // namespace
+
+correlation_matrix compute_correlation_matrix(const std::vector<std::shared_ptr<const price_series>>& series,
+                                              std::optional<std::int32_t> from,
+                                              std::optional<std::int32_t> to) {
+    const std::size_t n = series.size();
+    if (n < 2) {
+        throw std::invalid_argument("At least two symbols are needed for a correlation matrix");
+    }
+    if (n > correlation_max_symbols) {
+        throw std::invalid_argument("At most " + std::to_string(correlation_max_symbols) +
+                                    " symbols can be compared at once");
+    }
+
+    const std::vector<std::int32_t> days = common_days(series, from, to);
+    if (days.size() < 3) {
+        throw std::invalid_argument("The symbols share fewer than three dates in the window");
+    }
+
+    correlation_matrix m;
+    m.symbols.reserve(n);
+    for (const auto& s : series) {
+        m.symbols.push_back(s->symbol);
+    }
+    m.observations = days.size() - 1;
+    m.first_day = days.front();
+    m.last_day = days.back();
+    const std::size_t t = m.observations;
+
+    // One centered return column per symbol, shared by all of its pairs
+    std::vector<std::vector<double>> columns(n);
+    std::vector<double> sum_sq(n);
+    compute_pool& pool = compute_pool::getInstance();
+    pool.parallel_for(n, [&](std::size_t i) {
+        std::vector<double>& x = columns[i];
+        x.resize(days.size());
+        gather_prices(*series[i], days, x.data());
+        // Returns in place: x[k + 1] is still a price when x[k] is replaced
+        double total = 0.0;
+        for (std::size_t k = 0; k < t; ++k) {
+            x[k] = x[k + 1] / x[k] - 1.0;
+            total += x[k];
+        }
+        x.pop_back();
+        const double mean = total / static_cast<double>(t);
+        double ss = 0.0;
+        for (double& r : x) {
+            r -= mean;
+            ss += r * r;
+        }
+        sum_sq[i] = ss;
+    });
+
+    // Upper-triangle tiles; each fills its own cells and their mirror images
+    const std::size_t blocks = (n + tile_symbols - 1) / tile_symbols;
+    std::vector<std::pair<std::size_t, std::size_t>> tiles;
+    for (std::size_t bi = 0; bi < blocks; ++bi) {
+        for (std::size_t bj = bi; bj < blocks; ++bj) {
+            tiles.emplace_back(bi, bj);
+        }
+    }
+
+    m.covariance.assign(n * n, 0.0);
+    m.correlation.assign(n * n, 0.0);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    pool.parallel_for(tiles.size(), [&](std::size_t tile) {
+        const std::size_t i0 = tiles[tile].first * tile_symbols;
+        const std::size_t j0 = tiles[tile].second * tile_symbols;
+        const std::size_t i1 = std::min(i0 + tile_symbols, n);
+        const std::size_t j1 = std::min(j0 + tile_symbols, n);
+        double acc[tile_symbols][tile_symbols] = {};
+        for (std::size_t r = 0; r < t; r += tile_rows) {
+            const std::size_t len = std::min(tile_rows, t - r);
+            for (std::size_t i = i0; i < i1; ++i) {
+                for (std::size_t j = std::max(j0, i); j < j1; ++j) {
+                    acc[i - i0][j - j0] += dot(columns[i].data() + r, columns[j].data() + r, len);
+                }
+            }
+        }
+        for (std::size_t i = i0; i < i1; ++i) {
+            for (std::size_t j = std::max(j0, i); j < j1; ++j) {
+                const double d = acc[i - i0][j - j0];
+                const double cov = d / static_cast<double>(t - 1);
+                const double norm = std::sqrt(sum_sq[i] * sum_sq[j]);
+                double corr = norm > 0.0 ? std::clamp(d / norm, -1.0, 1.0) : nan;
+                if (i == j && norm > 0.0) {
+                    corr = 1.0;
+                }
+                m.covariance[i * n + j] = m.covariance[j * n + i] = cov;
+                m.correlation[i * n + j] = m.correlation[j * n + i] = corr;
+            }
+        }
+    });
+    return m;
+}
+
+void write_correlation_matrix(json_writer& w, const correlation_matrix& m) {
+    const std::size_t n = m.symbols.size();
+    auto write_matrix = [&](const std::vector<double>& values) {
+        w.begin_array();
+        for (std::size_t i = 0; i < n; ++i) {
+            w.begin_array();
+            for (std::size_t j = 0; j < n; ++j) {
+                w.value(values[i * n + j]);
+            }
+            w.end_array();
+        }
+        w.end_array();
+    };
+
+    w.begin_object();
+    w.key("correlation");
+    write_matrix(m.correlation);
+    w.key("covariance");
+    write_matrix(m.covariance);
+    w.key("from").value(format_day(m.first_day));
+    w.key("observations").value(m.observations);
+    w.key("symbols").begin_array();
+    for (const auto& s : m.symbols) {
+        w.value(s);
+    }
+    w.end_array();
+    w.key("to").value(format_day(m.last_day));
+    w.end_object();
+}
@@ -0,0 +1,211 @@
+// series_pyramid.cpp
+#include "series_pyramid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "date_utils.hpp"
+
+namespace {
+
+// Key shared by all days of one bar; keys increase with the day
+std::int32_t bucket_of(series_resolution resolution, std::int32_t day) {
+    return resolution == series_resolution::weekly ? week_number(day) : month_number(day);
+}
+
+template <class T>
+void truncate(series_column<T>& column, std::size_t n) {
+    column.values().resize(n);
+}
+
+} // namespace
+
+const char* series_resolution_name(series_resolution resolution) noexcept {
+    switch (resolution) {
+        case series_resolution::daily: return "daily";
+        case series_resolution::weekly: return "weekly";
+        case series_resolution::monthly: return "monthly";
+    }
+    return "daily";
+}
+
+series_pyramid::series_pyramid(const price_series& series) {
+    levels_[0].bars.symbol = series.symbol;
+    levels_[1].bars.symbol = series.symbol;
+    build_level(levels_[0], series_resolution::weekly, series, 0);
+    build_level(levels_[1], series_resolution::monthly, series, 0);
+}
+
+series_pyramid::series_pyramid(const price_series& series, const series_pyramid& previous, std::size_t first_changed)
+    : levels_(previous.levels_)
+{
+    if (first_changed >= series.size()) {
+        return;
+    }
+    const series_resolution resolutions[] = {series_resolution::weekly, series_resolution::monthly};
+    for (std::size_t l = 0; l < levels_.size(); ++l) {
+        level& lv = levels_[l];
+        const std::int32_t cutoff = bucket_of(resolutions[l], series.day[first_changed]);
+
+        // Rows before first_changed are unchanged; the bar holding the first
+        // changed row and everything after it is rebuilt
+        std::size_t kept = lv.bars.size();
+        while (kept > 0 && bucket_of(resolutions[l], lv.bars.day[kept - 1]) >= cutoff) {
+            --kept;
+        }
+        std::size_t start = first_changed;
+        while (start > 0 && bucket_of(resolutions[l], series.day[start - 1]) >= cutoff) {
+            --start;
+        }
+
+        price_series& bars = lv.bars;
+        truncate(bars.day, kept);
+        truncate(bars.price, kept);
+        truncate(bars.open, kept);
+        truncate(bars.high, kept);
+        truncate(bars.low, kept);
+        truncate(bars.volume, kept);
+        truncate(bars.change_percent, kept);
+        lv.first_row.resize(kept);
+        build_level(lv, resolutions[l], series, start);
+    }
+}
+
+void series_pyramid::build_level(level& out, series_resolution resolution, const price_series& series,
+                                 std::size_t first_row) {
+    const std::size_t n = series.size();
+    price_series& bars = out.bars;
+    std::size_t i = first_row;
+    while (i < n) {
+        const std::int32_t key = bucket_of(resolution, series.day[i]);
+        const std::size_t begin = i;
+        double high = series.high[i];
+        double low = series.low[i];
+        double volume = 0.0;
+        bool has_volume = false;
+        for (; i < n && bucket_of(resolution, series.day[i]) == key; ++i) {
+            high = std::max(high, series.high[i]);
+            low = std::min(low, series.low[i]);
+            if (!std::isnan(series.volume[i])) {
+                volume += series.volume[i];
+                has_volume = true;
+            }
+        }
+
+        const double close = series.price[i - 1];
+        // Close before the bar; for the first row, implied by its own change
+        const double prev_close = begin > 0
+            ? series.price[begin - 1]
+            : series.price[0] / (1.0 + series.change_percent[0] / 100.0);
+        double change = (close / prev_close - 1.0) * 100.0;
+        change = std::isfinite(change) ? std::round(change * 100.0) / 100.0 : 0.0;
+
+        bars.push_back(price_record{
+            series.day[begin],
+            close,
+            series.open[begin],
+            high,
+            low,
+            has_volume ? volume : std::nan(""),
+            change});
+        out.first_row.push_back(static_cast<std::uint32_t>(begin));
+    }
+}
+
+const series_pyramid::level& series_pyramid::level_of(series_resolution resolution) const {
+    switch (resolution) {
+        case series_resolution::weekly: return levels_[0];
+        case series_resolution::monthly: return levels_[1];
+        default: break;
+    }
+    throw std::invalid_argument("The daily resolution has no bars");
+}
+
+const price_series& series_pyramid::bars(series_resolution resolution) const {
+    return level_of(resolution).bars;
+}
+
+row_range series_pyramid::bars_covering(series_resolution resolution, row_range rows) const {
+    if (rows.empty()) {
+        return {};
+    }
+    const auto& first = level_of(resolution).first_row;
+    // Last bar starting at or before rows.begin, up to the first bar
+    // starting at or after rows.end
+    auto begin = std::upper_bound(first.begin(), first.end(), rows.begin);
+    auto end = std::lower_bound(first.begin(), first.end(), rows.end);
+    row_range r;
+    r.begin = static_cast<std::size_t>(begin - first.begin());
+    r.begin = r.begin > 0 ? r.begin - 1 : 0;
+    r.end = static_cast<std::size_t>(end - first.begin());
+    return r;
+}
+
+std::size_t series_pyramid::memory_bytes() const noexcept {
+    std::size_t bytes = sizeof(*this);
+    for (const auto& lv : levels_) {
+        bytes += lv.bars.memory_bytes() + lv.first_row.capacity() * sizeof(std::uint32_t);
+    }
+    return bytes;
+}
+
+std::vector<std::size_t> lttb_downsample(const price_series& series, row_range range, std::size_t points) {
+    std::vector<std::size_t> out;
+    const std::size_t n = range.empty() ? 0 : range.size();
+    if (points >= n || n == 0) {
+        out.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = range.begin + i;
+        }
+        return out;
+    }
+    if (points < 3) {
+        out.push_back(range.begin);
+        if (points == 2) {
+            out.push_back(range.end - 1);
+        }
+        return out;
+    }
+
+    out.reserve(points);
+    out.push_back(range.begin);
+    // Interior rows split into points - 2 buckets; from each, the row forming
+    // the largest triangle with the last pick and the next bucket's mean
+    const double every = static_cast<double>(n - 2) / static_cast<double>(points - 2);
+    auto bucket_start = [&](std::size_t b) {
+        return std::min(range.begin + 1 + static_cast<std::size_t>(static_cast<double>(b) * every), range.end - 1);
+    };
+    std::size_t a = range.begin;
+    for (std::size_t b = 0; b < points - 2; ++b) {
+        const std::size_t begin = bucket_start(b);
+        const std::size_t end = bucket_start(b + 1);
+        const std::size_t next_begin = end;
+        const std::size_t next_end = b + 2 < points - 1 ? bucket_start(b + 2) : range.end;
+
+        double avg_x = 0.0;
+        double avg_y = 0.0;
+        for (std::size_t i = next_begin; i < next_end; ++i) {
+            avg_x += series.day[i];
+            avg_y += series.price[i];
+        }
+        const double count = static_cast<double>(std::max<std::size_t>(next_end - next_begin, 1));
+        avg_x /= count;
+        avg_y /= count;
+
+        const double ax = series.day[a];
+        const double ay = series.price[a];
+        double best_area = -1.0;
+        std::size_t best = begin;
+        for (std::size_t i = begin; i < end; ++i) {
+            const double area = std::abs((ax - avg_x) * (series.price[i] - ay) -
+                                         (ax - series.day[i]) * (avg_y - ay));
+            if (area > best_area) {
+                best_area = area;
+                best = i;
+            }
+        }
+        out.push_back(best);
+        a = best;
+    }
+    out.push_back(range.end - 1);
+    return out;
+}
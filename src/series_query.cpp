@@ -0,0 +1,145 @@
+// series_query.cpp
+#include "series_query.hpp"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "date_utils.hpp"
+
+namespace {
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    while (!s.empty() && s.back() == ' ') s.remove_suffix(1);
+    return s;
+}
+
+} // namespace
+
+unsigned parse_series_fields(std::string_view list) {
+    static constexpr std::pair<std::string_view, series_field> names[] = {
+        {"Date", field_date},
+        {"Price", field_price},
+        {"Open", field_open},
+        {"High", field_high},
+        {"Low", field_low},
+        {"Volume", field_volume},
+        {"ChangePercent", field_change_percent},
+    };
+
+    unsigned fields = field_date;
+    while (!list.empty()) {
+        auto comma = list.find(',');
+        std::string_view name = trim(list.substr(0, comma));
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+        if (name.empty()) {
+            continue;
+        }
+        auto it = std::find_if(std::begin(names), std::end(names),
+                               [name](const auto& entry) { return iequals(entry.first, name); });
+        if (it == std::end(names)) {
+            throw std::invalid_argument("Unknown field: " + std::string(name));
+        }
+        fields |= it->second;
+    }
+    return fields;
+}
+
+row_range find_day_range(const price_series& series,
+                         std::optional<std::int32_t> from,
+                         std::optional<std::int32_t> to) {
+    const auto& day = series.day;
+    auto first = from ? std::lower_bound(day.begin(), day.end(), *from) : day.begin();
+    auto last = to ? std::upper_bound(first, day.end(), *to) : day.end();
+    return {static_cast<std::size_t>(first - day.begin()), static_cast<std::size_t>(last - day.begin())};
+}
+
+std::vector<std::int32_t> common_days(const std::vector<std::shared_ptr<const price_series>>& series,
+                                      std::optional<std::int32_t> from,
+                                      std::optional<std::int32_t> to) {
+    std::vector<std::int32_t> days;
+    if (series.empty()) {
+        return days;
+    }
+    row_range r = find_day_range(*series[0], from, to);
+    days.assign(series[0]->day.begin() + r.begin, series[0]->day.begin() + r.end);
+    std::vector<std::int32_t> next;
+    for (std::size_t i = 1; i < series.size() && !days.empty(); ++i) {
+        const price_series& s = *series[i];
+        r = find_day_range(s, from, to);
+        next.clear();
+        std::set_intersection(days.begin(), days.end(), s.day.begin() + r.begin, s.day.begin() + r.end,
+                              std::back_inserter(next));
+        days.swap(next);
+    }
+    return days;
+}
+
+void gather_prices(const price_series& series, const std::vector<std::int32_t>& days, double* out) {
+    if (days.empty()) {
+        return;
+    }
+    std::size_t row = static_cast<std::size_t>(
+        std::lower_bound(series.day.begin(), series.day.end(), days.front()) - series.day.begin());
+    for (std::size_t k = 0; k < days.size(); ++k) {
+        while (series.day[row] < days[k]) {
+            ++row;
+        }
+        out[k] = series.price[row];
+    }
+}
+
+void write_series_row(json_writer& writer, const price_series& series, std::size_t i, unsigned fields) {
+    writer.begin_object();
+    if (fields & field_change_percent) writer.key("ChangePercent").value(series.change_percent[i]);
+    if (fields & field_date) writer.key("Date").value(format_day(series.day[i]));
+    if (fields & field_high) writer.key("High").value(series.high[i]);
+    if (fields & field_low) writer.key("Low").value(series.low[i]);
+    if (fields & field_open) writer.key("Open").value(series.open[i]);
+    if (fields & field_price) writer.key("Price").value(series.price[i]);
+    if (fields & field_volume) writer.key("Volume").value(format_volume(series.volume[i]));
+    writer.end_object();
+}
+
+series_json_stream::series_json_stream(std::shared_ptr<const price_series> series, row_range range, unsigned fields)
+    : series_(std::move(series)), range_(range), fields_(fields), next_(range.end)
+{
+}
+
+bool series_json_stream::operator()(std::string& out) {
+    switch (stage_) {
+        case stage::prefix:
+            out += "{\"data\":[";
+            stage_ = range_.empty() ? stage::suffix : stage::rows;
+            return true;
+        case stage::rows:
+            --next_;
+            if (next_ != range_.end - 1) {
+                out += ',';
+            }
+            {
+                json_writer writer(out);
+                write_series_row(writer, *series_, next_, fields_);
+            }
+            if (next_ == range_.begin) {
+                stage_ = stage::suffix;
+            }
+            return true;
+        case stage::suffix:
+            out += "],\"ok\":true,\"status_code\":200}";
+            stage_ = stage::done;
+            return false;
+        case stage::done:
+            break;
+    }
+    return false;
+}
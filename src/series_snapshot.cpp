@@ -0,0 +1,249 @@
+// series_snapshot.cpp
+#include "series_snapshot.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <sys/stat.h>
+#include "mapped_file.hpp"
+
+namespace {
+
+constexpr char snapshot_magic[8] = {'C', 'A', 'P', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::uint32_t snapshot_byte_order = 0x01020304;
+constexpr std::size_t snapshot_alignment = 64;
+constexpr std::uint32_t snapshot_column_count = 7;
+
+// On-disk structures; every field is naturally aligned so there is no padding
+struct raw_column {
+    std::uint32_t id;
+    std::uint32_t element_size;
+    std::uint64_t offset;
+    std::uint64_t bytes;
+};
+
+struct raw_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t header_size;
+    std::uint32_t column_count;
+    std::uint64_t rows;
+    std::uint64_t file_size;
+    std::uint64_t source_size;
+    std::int64_t source_mtime_ns;
+    std::uint64_t checksum;
+    char symbol[64];
+    raw_column columns[snapshot_column_count];
+};
+
+static_assert(sizeof(raw_column) == 24, "snapshot column entry layout changed");
+static_assert(sizeof(raw_header) == 296, "snapshot header layout changed");
+
+std::size_t align_up(std::size_t n) {
+    return (n + snapshot_alignment - 1) / snapshot_alignment * snapshot_alignment;
+}
+
+// FNV-1a over 64-bit words, with the tail folded in byte by byte
+std::uint64_t fnv1a(std::uint64_t hash, const char* data, std::size_t size) {
+    constexpr std::uint64_t prime = 0x100000001b3ULL;
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+    }
+    return hash;
+}
+
+constexpr std::uint64_t fnv1a_offset_basis = 0xcbf29ce484222325ULL;
+
+struct column_source {
+    const char* data;
+    std::uint32_t element_size;
+    std::size_t bytes;
+};
+
+// Columns in on-disk order; the index is the column id
+std::array<column_source, snapshot_column_count> columns_of(const price_series& s) {
+    auto source = [](const auto& column) {
+        using T = std::decay_t<decltype(column[0])>;
+        return column_source{reinterpret_cast<const char*>(column.data()),
+                             static_cast<std::uint32_t>(sizeof(T)), column.size() * sizeof(T)};
+    };
+    return {source(s.day), source(s.price), source(s.open), source(s.high),
+            source(s.low), source(s.volume), source(s.change_percent)};
+}
+
+bool stat_file(const std::string& path, std::uint64_t& size, std::int64_t& mtime_ns) {
+    struct stat st {};
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    size = static_cast<std::uint64_t>(st.st_size);
+    mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+template <class T>
+series_column<T> borrow_column(const std::shared_ptr<const mapped_file>& file, const raw_column& entry,
+                               std::uint64_t rows) {
+    return series_column<T>(reinterpret_cast<const T*>(file->data() + entry.offset),
+                            static_cast<std::size_t>(rows), file);
+}
+
+} // namespace
+
+std::string snapshot_file_name(const std::string& root, std::string_view symbol) {
+    std::string path = root;
+    if (!path.empty() && path.back() != '/') {
+        path.push_back('/');
+    }
+    path.append(symbol);
+    path.append(".capsnap");
+    return path;
+}
+
+void write_series_snapshot(const price_series& series, const std::string& path, const std::string& source_path) {
+    raw_header header {};
+    std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = series_snapshot_version;
+    header.byte_order = snapshot_byte_order;
+    header.header_size = sizeof(raw_header);
+    header.column_count = snapshot_column_count;
+    header.rows = series.size();
+    std::memcpy(header.symbol, series.symbol.data(), std::min(series.symbol.size(), sizeof(header.symbol) - 1));
+
+    if (!source_path.empty() && !stat_file(source_path, header.source_size, header.source_mtime_ns)) {
+        throw std::runtime_error("Failed to stat snapshot source: " + source_path);
+    }
+
+    const auto columns = columns_of(series);
+    std::size_t offset = align_up(sizeof(raw_header));
+    std::uint64_t checksum = fnv1a_offset_basis;
+    for (std::uint32_t i = 0; i < snapshot_column_count; ++i) {
+        if (columns[i].bytes != series.size() * columns[i].element_size) {
+            throw std::runtime_error("Snapshot of " + series.symbol + ": column lengths differ");
+        }
+        header.columns[i] = {i, columns[i].element_size, offset, columns[i].bytes};
+        checksum = fnv1a(checksum, columns[i].data, columns[i].bytes);
+        offset = align_up(offset + columns[i].bytes);
+    }
+    header.file_size = offset;
+    header.checksum = checksum;
+
+    // Write next to the target and rename over it, so a server mapping the
+    // old file keeps its pages and a new one never sees a partial file
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Failed to create snapshot: " + tmp_path + " (" + std::strerror(errno) + ")");
+        }
+        static const char zeros[snapshot_alignment] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        std::size_t written = sizeof(header);
+        for (std::uint32_t i = 0; i < snapshot_column_count; ++i) {
+            out.write(zeros, static_cast<std::streamsize>(header.columns[i].offset - written));
+            out.write(columns[i].data, static_cast<std::streamsize>(columns[i].bytes));
+            written = header.columns[i].offset + columns[i].bytes;
+        }
+        out.write(zeros, static_cast<std::streamsize>(header.file_size - written));
+        out.flush();
+        if (!out) {
+            std::remove(tmp_path.c_str());
+            throw std::runtime_error("Failed to write snapshot: " + tmp_path);
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Failed to rename snapshot to " + path + ": " + ec.message());
+    }
+}
+
+series_snapshot open_series_snapshot(const std::string& path, bool verify_checksum) {
+    auto file = std::make_shared<const mapped_file>(path, mapped_file::access_hint::normal);
+    auto fail = [&path](const std::string& reason) {
+        return std::runtime_error("Invalid snapshot " + path + ": " + reason);
+    };
+
+    if (file->size() < sizeof(raw_header)) {
+        throw fail("file too small");
+    }
+    raw_header header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0) {
+        throw fail("bad magic");
+    }
+    if (header.version != series_snapshot_version) {
+        throw fail("version " + std::to_string(header.version) + ", expected " +
+                   std::to_string(series_snapshot_version));
+    }
+    if (header.byte_order != snapshot_byte_order) {
+        throw fail("written on a machine with a different byte order");
+    }
+    if (header.header_size != sizeof(raw_header) || header.column_count != snapshot_column_count) {
+        throw fail("unexpected header layout");
+    }
+    if (header.file_size != file->size() || header.rows > file->size()) {
+        throw fail("truncated (" + std::to_string(file->size()) + " of " +
+                   std::to_string(header.file_size) + " bytes)");
+    }
+
+    static constexpr std::uint32_t element_sizes[snapshot_column_count] = {
+        sizeof(std::int32_t), sizeof(double), sizeof(double), sizeof(double),
+        sizeof(double), sizeof(double), sizeof(double)};
+    std::uint64_t checksum = fnv1a_offset_basis;
+    for (std::uint32_t i = 0; i < snapshot_column_count; ++i) {
+        const raw_column& c = header.columns[i];
+        if (c.id != i || c.element_size != element_sizes[i] || c.offset % snapshot_alignment != 0 ||
+            c.bytes != header.rows * c.element_size || c.offset > file->size() ||
+            c.bytes > file->size() - c.offset) {
+            throw fail("column " + std::to_string(i) + " out of bounds");
+        }
+        if (verify_checksum) {
+            checksum = fnv1a(checksum, file->data() + c.offset, c.bytes);
+        }
+    }
+    if (verify_checksum && checksum != header.checksum) {
+        throw fail("checksum mismatch");
+    }
+
+    series_snapshot snapshot;
+    snapshot.info.version = header.version;
+    snapshot.info.rows = header.rows;
+    snapshot.info.file_size = header.file_size;
+    snapshot.info.source_size = header.source_size;
+    snapshot.info.source_mtime_ns = header.source_mtime_ns;
+    snapshot.info.checksum = header.checksum;
+    snapshot.info.symbol.assign(header.symbol, strnlen(header.symbol, sizeof(header.symbol)));
+
+    price_series& s = snapshot.series;
+    s.symbol = snapshot.info.symbol;
+    s.day = borrow_column<std::int32_t>(file, header.columns[0], header.rows);
+    s.price = borrow_column<double>(file, header.columns[1], header.rows);
+    s.open = borrow_column<double>(file, header.columns[2], header.rows);
+    s.high = borrow_column<double>(file, header.columns[3], header.rows);
+    s.low = borrow_column<double>(file, header.columns[4], header.rows);
+    s.volume = borrow_column<double>(file, header.columns[5], header.rows);
+    s.change_percent = borrow_column<double>(file, header.columns[6], header.rows);
+    return snapshot;
+}
+
+bool snapshot_matches_source(const snapshot_info& info, const std::string& source_path) {
+    std::uint64_t size = 0;
+    std::int64_t mtime_ns = 0;
+    return stat_file(source_path, size, mtime_ns) && size == info.source_size && mtime_ns == info.source_mtime_ns;
+}
@@ -0,0 +1,482 @@
+// series_stats.cpp
+#include "series_stats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "date_utils.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CAP_STATS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr double inf = std::numeric_limits<double>::infinity();
+
+struct moments {
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    double min = inf;
+    double max = -inf;
+};
+
+struct volatility_range {
+    double min = inf;
+    double max = -inf;
+};
+
+// Lowest price / running peak, and where it occurred
+struct drawdown {
+    double ratio = inf;
+    std::size_t trough = 0;
+};
+
+// One implementation of each kernel per instruction set. The scalar versions
+// also finish the tails the vector loops leave over, continuing from the
+// state the vector loop reached.
+struct kernel_set {
+    // out[i - 1] = price[i] / price[i - 1] - 1 for i in [1, n)
+    void (*simple_returns)(const double* price, std::size_t n, double* out);
+    moments (*summarize)(const double* x, std::size_t n);
+    // Extremes of the window standard deviation for windows [i, i + window),
+    // i in [0, count), given prefix sums of x and x^2 (sum[0] == 0)
+    volatility_range (*rolling_volatility)(const double* sum, const double* sum_sq,
+                                           std::size_t count, std::size_t window);
+    drawdown (*max_drawdown)(const double* price, std::size_t n);
+};
+
+namespace scalar {
+
+void simple_returns(const double* price, std::size_t n, double* out, std::size_t begin) {
+    for (std::size_t i = std::max<std::size_t>(begin, 1); i < n; ++i) {
+        out[i - 1] = price[i] / price[i - 1] - 1.0;
+    }
+}
+
+void simple_returns(const double* price, std::size_t n, double* out) {
+    simple_returns(price, n, out, 1);
+}
+
+moments summarize(const double* x, std::size_t n, std::size_t begin, moments m) {
+    for (std::size_t i = begin; i < n; ++i) {
+        m.sum += x[i];
+        m.sum_sq += x[i] * x[i];
+        m.min = std::min(m.min, x[i]);
+        m.max = std::max(m.max, x[i]);
+    }
+    return m;
+}
+
+moments summarize(const double* x, std::size_t n) {
+    return summarize(x, n, 0, moments{});
+}
+
+inline double window_stddev(const double* sum, const double* sum_sq, std::size_t i, std::size_t window) {
+    const double w = static_cast<double>(window);
+    const double mean = (sum[i + window] - sum[i]) / w;
+    const double var = ((sum_sq[i + window] - sum_sq[i]) - mean * mean * w) / (w - 1.0);
+    return std::sqrt(std::max(var, 0.0));
+}
+
+volatility_range rolling_volatility(const double* sum, const double* sum_sq, std::size_t count,
+                                    std::size_t window, std::size_t begin, volatility_range r) {
+    for (std::size_t i = begin; i < count; ++i) {
+        const double sd = window_stddev(sum, sum_sq, i, window);
+        r.min = std::min(r.min, sd);
+        r.max = std::max(r.max, sd);
+    }
+    return r;
+}
+
+volatility_range rolling_volatility(const double* sum, const double* sum_sq, std::size_t count, std::size_t window) {
+    return rolling_volatility(sum, sum_sq, count, window, 0, volatility_range{});
+}
+
+drawdown max_drawdown(const double* price, std::size_t n, std::size_t begin, double peak, drawdown d) {
+    for (std::size_t i = begin; i < n; ++i) {
+        peak = std::max(peak, price[i]);
+        const double ratio = price[i] / peak;
+        if (ratio < d.ratio) {
+            d.ratio = ratio;
+            d.trough = i;
+        }
+    }
+    return d;
+}
+
+drawdown max_drawdown(const double* price, std::size_t n) {
+    return max_drawdown(price, n, 0, -inf, drawdown{});
+}
+
+constexpr kernel_set kernels{simple_returns, summarize, rolling_volatility, max_drawdown};
+
+} // namespace scalar
+
+#ifdef CAP_STATS_X86
+
+namespace sse2 {
+
+#define CAP_SSE2 __attribute__((target("sse2")))
+
+CAP_SSE2 inline double hmin(__m128d v) { return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v))); }
+CAP_SSE2 inline double hmax(__m128d v) { return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v))); }
+CAP_SSE2 inline double hsum(__m128d v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+
+CAP_SSE2 void simple_returns(const double* price, std::size_t n, double* out) {
+    const __m128d one = _mm_set1_pd(1.0);
+    std::size_t i = 1;
+    for (; i + 2 <= n; i += 2) {
+        __m128d prev = _mm_loadu_pd(price + i - 1);
+        __m128d cur = _mm_loadu_pd(price + i);
+        _mm_storeu_pd(out + i - 1, _mm_sub_pd(_mm_div_pd(cur, prev), one));
+    }
+    scalar::simple_returns(price, n, out, i);
+}
+
+CAP_SSE2 moments summarize(const double* x, std::size_t n) {
+    __m128d sum = _mm_setzero_pd();
+    __m128d sum_sq = _mm_setzero_pd();
+    __m128d lo = _mm_set1_pd(inf);
+    __m128d hi = _mm_set1_pd(-inf);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(x + i);
+        sum = _mm_add_pd(sum, v);
+        sum_sq = _mm_add_pd(sum_sq, _mm_mul_pd(v, v));
+        lo = _mm_min_pd(lo, v);
+        hi = _mm_max_pd(hi, v);
+    }
+    return scalar::summarize(x, n, i, moments{hsum(sum), hsum(sum_sq), hmin(lo), hmax(hi)});
+}
+
+CAP_SSE2 volatility_range rolling_volatility(const double* sum, const double* sum_sq, std::size_t count,
+                                             std::size_t window) {
+    const double w = static_cast<double>(window);
+    const __m128d vw = _mm_set1_pd(w);
+    const __m128d inv_w = _mm_set1_pd(1.0 / w);
+    const __m128d inv_w1 = _mm_set1_pd(1.0 / (w - 1.0));
+    const __m128d zero = _mm_setzero_pd();
+    __m128d lo = _mm_set1_pd(inf);
+    __m128d hi = _mm_set1_pd(-inf);
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d s = _mm_sub_pd(_mm_loadu_pd(sum + i + window), _mm_loadu_pd(sum + i));
+        __m128d q = _mm_sub_pd(_mm_loadu_pd(sum_sq + i + window), _mm_loadu_pd(sum_sq + i));
+        __m128d mean = _mm_mul_pd(s, inv_w);
+        __m128d var = _mm_mul_pd(_mm_sub_pd(q, _mm_mul_pd(_mm_mul_pd(mean, mean), vw)), inv_w1);
+        __m128d sd = _mm_sqrt_pd(_mm_max_pd(var, zero));
+        lo = _mm_min_pd(lo, sd);
+        hi = _mm_max_pd(hi, sd);
+    }
+    return scalar::rolling_volatility(sum, sum_sq, count, window, i, volatility_range{hmin(lo), hmax(hi)});
+}
+
+CAP_SSE2 drawdown max_drawdown(const double* price, std::size_t n) {
+    const __m128d neg_inf = _mm_set1_pd(-inf);
+    const __m128d step = _mm_set1_pd(2.0);
+    __m128d carry = neg_inf;
+    __m128d best = _mm_set1_pd(inf);
+    __m128d best_index = _mm_setzero_pd();
+    __m128d index = _mm_set_pd(1.0, 0.0);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d p = _mm_loadu_pd(price + i);
+        // Running peak: prefix max within the register, then the carry-in
+        __m128d peak = _mm_max_pd(p, _mm_unpacklo_pd(neg_inf, p));
+        peak = _mm_max_pd(peak, carry);
+        carry = _mm_unpackhi_pd(peak, peak);
+
+        __m128d ratio = _mm_div_pd(p, peak);
+        __m128d lower = _mm_cmplt_pd(ratio, best);
+        best = _mm_or_pd(_mm_and_pd(lower, ratio), _mm_andnot_pd(lower, best));
+        best_index = _mm_or_pd(_mm_and_pd(lower, index), _mm_andnot_pd(lower, best_index));
+        index = _mm_add_pd(index, step);
+    }
+
+    alignas(16) double ratios[2];
+    alignas(16) double indexes[2];
+    _mm_store_pd(ratios, best);
+    _mm_store_pd(indexes, best_index);
+    drawdown d;
+    for (int lane = 0; lane < 2; ++lane) {
+        auto at = static_cast<std::size_t>(indexes[lane]);
+        if (ratios[lane] < d.ratio || (ratios[lane] == d.ratio && at < d.trough)) {
+            d = drawdown{ratios[lane], at};
+        }
+    }
+    return scalar::max_drawdown(price, n, i, _mm_cvtsd_f64(carry), d);
+}
+
+#undef CAP_SSE2
+
+constexpr kernel_set kernels{simple_returns, summarize, rolling_volatility, max_drawdown};
+
+} // namespace sse2
+
+namespace avx2 {
+
+#define CAP_AVX2 __attribute__((target("avx2")))
+
+CAP_AVX2 inline double hmin(__m256d v) {
+    __m128d m = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_min_sd(m, _mm_unpackhi_pd(m, m)));
+}
+
+CAP_AVX2 inline double hmax(__m256d v) {
+    __m128d m = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+}
+
+CAP_AVX2 inline double hsum(__m256d v) {
+    __m128d m = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(m, _mm_unpackhi_pd(m, m)));
+}
+
+CAP_AVX2 void simple_returns(const double* price, std::size_t n, double* out) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    std::size_t i = 1;
+    for (; i + 4 <= n; i += 4) {
+        __m256d prev = _mm256_loadu_pd(price + i - 1);
+        __m256d cur = _mm256_loadu_pd(price + i);
+        _mm256_storeu_pd(out + i - 1, _mm256_sub_pd(_mm256_div_pd(cur, prev), one));
+    }
+    scalar::simple_returns(price, n, out, i);
+}
+
+CAP_AVX2 moments summarize(const double* x, std::size_t n) {
+    __m256d sum = _mm256_setzero_pd();
+    __m256d sum_sq = _mm256_setzero_pd();
+    __m256d lo = _mm256_set1_pd(inf);
+    __m256d hi = _mm256_set1_pd(-inf);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        sum = _mm256_add_pd(sum, v);
+        sum_sq = _mm256_add_pd(sum_sq, _mm256_mul_pd(v, v));
+        lo = _mm256_min_pd(lo, v);
+        hi = _mm256_max_pd(hi, v);
+    }
+    return scalar::summarize(x, n, i, moments{hsum(sum), hsum(sum_sq), hmin(lo), hmax(hi)});
+}
+
+CAP_AVX2 volatility_range rolling_volatility(const double* sum, const double* sum_sq, std::size_t count,
+                                             std::size_t window) {
+    const double w = static_cast<double>(window);
+    const __m256d vw = _mm256_set1_pd(w);
+    const __m256d inv_w = _mm256_set1_pd(1.0 / w);
+    const __m256d inv_w1 = _mm256_set1_pd(1.0 / (w - 1.0));
+    const __m256d zero = _mm256_setzero_pd();
+    __m256d lo = _mm256_set1_pd(inf);
+    __m256d hi = _mm256_set1_pd(-inf);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d s = _mm256_sub_pd(_mm256_loadu_pd(sum + i + window), _mm256_loadu_pd(sum + i));
+        __m256d q = _mm256_sub_pd(_mm256_loadu_pd(sum_sq + i + window), _mm256_loadu_pd(sum_sq + i));
+        __m256d mean = _mm256_mul_pd(s, inv_w);
+        __m256d var = _mm256_mul_pd(_mm256_sub_pd(q, _mm256_mul_pd(_mm256_mul_pd(mean, mean), vw)), inv_w1);
+        __m256d sd = _mm256_sqrt_pd(_mm256_max_pd(var, zero));
+        lo = _mm256_min_pd(lo, sd);
+        hi = _mm256_max_pd(hi, sd);
+    }
+    return scalar::rolling_volatility(sum, sum_sq, count, window, i, volatility_range{hmin(lo), hmax(hi)});
+}
+
+CAP_AVX2 drawdown max_drawdown(const double* price, std::size_t n) {
+    const __m256d neg_inf = _mm256_set1_pd(-inf);
+    const __m256d step = _mm256_set1_pd(4.0);
+    __m256d carry = neg_inf;
+    __m256d best = _mm256_set1_pd(inf);
+    __m256d best_index = _mm256_setzero_pd();
+    __m256d index = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d p = _mm256_loadu_pd(price + i);
+        // Running peak: log-step prefix max across the four lanes (shift by
+        // one lane, then by two), then the peak carried in from the left
+        __m256d peak = _mm256_max_pd(
+            p, _mm256_blend_pd(_mm256_permute4x64_pd(p, _MM_SHUFFLE(2, 1, 0, 0)), neg_inf, 0x1));
+        peak = _mm256_max_pd(
+            peak, _mm256_blend_pd(_mm256_permute4x64_pd(peak, _MM_SHUFFLE(1, 0, 0, 0)), neg_inf, 0x3));
+        peak = _mm256_max_pd(peak, carry);
+        carry = _mm256_permute4x64_pd(peak, _MM_SHUFFLE(3, 3, 3, 3));
+
+        __m256d ratio = _mm256_div_pd(p, peak);
+        __m256d lower = _mm256_cmp_pd(ratio, best, _CMP_LT_OQ);
+        best = _mm256_blendv_pd(best, ratio, lower);
+        best_index = _mm256_blendv_pd(best_index, index, lower);
+        index = _mm256_add_pd(index, step);
+    }
+
+    alignas(32) double ratios[4];
+    alignas(32) double indexes[4];
+    _mm256_store_pd(ratios, best);
+    _mm256_store_pd(indexes, best_index);
+    drawdown d;
+    for (int lane = 0; lane < 4; ++lane) {
+        auto at = static_cast<std::size_t>(indexes[lane]);
+        if (ratios[lane] < d.ratio || (ratios[lane] == d.ratio && at < d.trough)) {
+            d = drawdown{ratios[lane], at};
+        }
+    }
+    return scalar::max_drawdown(price, n, i, _mm256_cvtsd_f64(carry), d);
+}
+
+#undef CAP_AVX2
+
+constexpr kernel_set kernels{simple_returns, summarize, rolling_volatility, max_drawdown};
+
+} // namespace avx2
+
+#endif // CAP_STATS_X86
+
+const kernel_set& kernels_for(simd_level level) {
+    switch (level) {
+#ifdef CAP_STATS_X86
+        case simd_level::avx2: return avx2::kernels;
+        case simd_level::sse2: return sse2::kernels;
+#endif
+        default: return scalar::kernels;
+    }
+}
+
+// Per-thread scratch columns, reused across requests
+struct stats_scratch {
+    std::vector<double> returns;
+    std::vector<double> sum;
+    std::vector<double> sum_sq;
+};
+
+} // namespace
+
+const char* simd_level_name(simd_level level) noexcept {
+    switch (level) {
+        case simd_level::avx2: return "avx2";
+        case simd_level::sse2: return "sse2";
+        case simd_level::scalar: break;
+    }
+    return "scalar";
+}
+
+simd_level best_simd_level() noexcept {
+#ifdef CAP_STATS_X86
+    static const simd_level level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return simd_level::avx2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return simd_level::sse2;
+        }
+        return simd_level::scalar;
+    }();
+    return level;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+series_stats compute_series_stats(const price_series& series, row_range range, std::size_t window,
+                                  simd_level level) {
+    if (range.size() < 2) {
+        throw std::invalid_argument("At least two rows are needed for statistics");
+    }
+    if (window < 2) {
+        throw std::invalid_argument("window must be at least 2");
+    }
+    if (level > best_simd_level()) {
+        level = best_simd_level();
+    }
+    const kernel_set& k = kernels_for(level);
+
+    const double* price = series.price.data() + range.begin;
+    const std::size_t n = range.size();
+    const std::size_t m = n - 1; // number of returns
+
+    thread_local stats_scratch scratch;
+    std::vector<double>& returns = scratch.returns;
+    returns.resize(m);
+    k.simple_returns(price, n, returns.data());
+
+    series_stats stats;
+    stats.level = level;
+    stats.rows = n;
+    stats.first_day = series.day[range.begin];
+    stats.last_day = series.day[range.end - 1];
+
+    const moments mo = k.summarize(returns.data(), m);
+    const double dm = static_cast<double>(m);
+    stats.cumulative_return = price[n - 1] / price[0] - 1.0;
+    stats.annualized_return = std::pow(1.0 + stats.cumulative_return, trading_days_per_year / dm) - 1.0;
+    stats.mean_return = mo.sum / dm;
+    stats.stddev_return = m > 1 ? std::sqrt(std::max(mo.sum_sq - mo.sum * stats.mean_return, 0.0) / (dm - 1.0)) : 0.0;
+    stats.min_return = mo.min;
+    stats.max_return = mo.max;
+    stats.annualized_volatility = stats.stddev_return * std::sqrt(trading_days_per_year);
+
+    stats.window = window;
+    if (m >= window) {
+        // Prefix sums make every window O(1); the scan itself is sequential
+        std::vector<double>& sum = scratch.sum;
+        std::vector<double>& sum_sq = scratch.sum_sq;
+        sum.resize(m + 1);
+        sum_sq.resize(m + 1);
+        sum[0] = 0.0;
+        sum_sq[0] = 0.0;
+        for (std::size_t i = 0; i < m; ++i) {
+            sum[i + 1] = sum[i] + returns[i];
+            sum_sq[i + 1] = sum_sq[i] + returns[i] * returns[i];
+        }
+        const std::size_t count = m - window + 1;
+        const volatility_range vr = k.rolling_volatility(sum.data(), sum_sq.data(), count, window);
+        stats.rolling_mean = (sum[m] - sum[m - window]) / static_cast<double>(window);
+        stats.rolling_volatility = scalar::window_stddev(sum.data(), sum_sq.data(), count - 1, window);
+        stats.min_rolling_volatility = vr.min;
+        stats.max_rolling_volatility = vr.max;
+    } else {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        stats.rolling_mean = stats.rolling_volatility = nan;
+        stats.min_rolling_volatility = stats.max_rolling_volatility = nan;
+    }
+
+    const drawdown dd = k.max_drawdown(price, n);
+    stats.max_drawdown = std::min(dd.ratio - 1.0, 0.0);
+    const std::size_t peak = static_cast<std::size_t>(std::max_element(price, price + dd.trough + 1) - price);
+    stats.drawdown_peak_day = series.day[range.begin + peak];
+    stats.drawdown_trough_day = series.day[range.begin + dd.trough];
+    return stats;
+}
+
+void write_series_stats(json_writer& w, std::string_view symbol, const series_stats& s) {
+    w.begin_object();
+    w.key("annualized_return").value(s.annualized_return);
+    w.key("annualized_volatility").value(s.annualized_volatility);
+    w.key("cumulative_return").value(s.cumulative_return);
+    w.key("daily_return").begin_object()
+        .key("max").value(s.max_return)
+        .key("mean").value(s.mean_return)
+        .key("min").value(s.min_return)
+        .key("stddev").value(s.stddev_return)
+        .end_object();
+    w.key("from").value(format_day(s.first_day));
+    w.key("kernel").value(simd_level_name(s.level));
+    w.key("max_drawdown").begin_object()
+        .key("depth").value(s.max_drawdown)
+        .key("peak").value(format_day(s.drawdown_peak_day))
+        .key("trough").value(format_day(s.drawdown_trough_day))
+        .end_object();
+    w.key("rolling").begin_object()
+        .key("max_volatility").value(s.max_rolling_volatility)
+        .key("mean").value(s.rolling_mean)
+        .key("min_volatility").value(s.min_rolling_volatility)
+        .key("volatility").value(s.rolling_volatility)
+        .key("window").value(s.window)
+        .end_object();
+    w.key("rows").value(s.rows);
+    w.key("symbol").value(symbol);
+    w.key("to").value(format_day(s.last_day));
+    w.end_object();
+}
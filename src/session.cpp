@@ -10,55 +10,117 @@ session::session(
 }
 */
 
-session::session(
-    tcp::socket&& socket,
+template <class Executor>
+basic_session<Executor>::basic_session(
+    socket_type&& socket,
     std::shared_ptr<std::string const> const& doc_root, 
     std::shared_ptr<IDatabase> db)
-    : stream_(std::move(socket)),  doc_root_(doc_root),  db_(db),  lambda_(*this)
+    : stream_(std::move(socket)),  doc_root_(doc_root),  db_(db),  queue_(*this)
 {
+    connection_pool::session_opened();
+    buffer_.reserve(session_buffer_bytes);
+}
+
+template <class Executor>
+basic_session<Executor>::~basic_session() {
+    // Hand the arenas back to the pool once nothing refers into them
+    parser_.reset();
+    queue_.clear();
+    if (arena_)
+        connection_pool::give_arena(std::move(arena_));
+    for (auto& arena : spare_arenas_)
+        connection_pool::give_arena(std::move(arena));
+    connection_pool::session_closed();
 }
 
 
-void session::run() {
+template <class Executor>
+void basic_session<Executor>::run() {
     net::dispatch(
         stream_.get_executor(),
         beast::bind_front_handler(
-            &session::do_read,
-            shared_from_this()));
+            &basic_session::do_read,
+            this->shared_from_this()));
 }
 
-void session::do_read() {
-    req_ = {};
+template <class Executor>
+void basic_session<Executor>::do_read() {
+    if (!arena_) {
+        if (spare_arenas_.empty()) {
+            arena_ = connection_pool::take_arena();
+        } else {
+            arena_ = std::move(spare_arenas_.back());
+            spare_arenas_.pop_back();
+        }
+    }
+    // Fields and body of the next request are allocated from its arena
+    parser_.emplace(
+        std::piecewise_construct,
+        std::make_tuple(arena_allocator(arena_.get())),
+        std::make_tuple(arena_allocator(arena_.get())));
+    reading_ = true;
 
     stream_.expires_after(std::chrono::seconds(30));
 
     http::async_read(
         stream_,
         buffer_,
-        req_,
+        *parser_,
         beast::bind_front_handler(
-            &session::on_read,
-            shared_from_this()));
+            &basic_session::on_read,
+            this->shared_from_this()));
 }
 
-void session::on_read(
+template <class Executor>
+void basic_session<Executor>::on_read(
     beast::error_code ec,
     std::size_t bytes_transferred)
 {
     boost::ignore_unused(bytes_transferred);
-
-    if (ec == http::error::end_of_stream)
-        return do_close();
+    reading_ = false;
+
+    if (ec == http::error::end_of_stream) {
+        // Finish writing the responses already queued before closing
+        read_eof_ = true;
+        if (queue_.empty())
+            return do_close();
+        return;
+    }
 
     if (ec)
         return fail(ec, "read");
 
-    // Send the response
-    handle_request(*doc_root_, std::move(req_), lambda_, db_);
-    //handle_request(*doc_root_, std::move(req_), lambda_);
+    // Queue the response; it is written once those before it are
+    const std::uint64_t queued = queue_.queued();
+    {
+        arena_request req = parser_->release();
+        parser_.reset();
+        head_ = req.method() == http::verb::head;
+        handle_request(*doc_root_, std::move(req), queue_, db_);
+        //handle_request(*doc_root_, std::move(req_), lambda_);
+    }
+    on_handled(queued);
+}
+
+template <class Executor>
+void basic_session<Executor>::on_handled(std::uint64_t queued) {
+    // Nothing was queued: the handler deferred the request, which keeps
+    // using its arena until the response is sent
+    deferred_ = queue_.queued() == queued;
+    if (deferred_)
+        return;
+
+    // No response took the arena; rewind it for the next request
+    if (arena_)
+        arena_->reset();
+
+    // Read the next pipelined request unless the queue is full
+    if (!closing_ && !queue_.is_full())
+        do_read();
 }
 
-void session::on_write(
+template <class Executor>
+void basic_session<Executor>::on_write(
     bool close,
     beast::error_code ec,
     std::size_t bytes_transferred)
@@ -72,12 +134,33 @@ void session::on_write(
         return do_close();
     }
 
-    res_ = nullptr;
+    // Resume reading if a full queue had paused it
+    if (queue_.on_write() && !reading_ && !deferred_ && !closing_ && !read_eof_)
+        do_read();
 
-    do_read();
+    if (read_eof_ && queue_.empty())
+        do_close();
 }
 
-void session::do_close() {
+template <class Executor>
+void basic_session<Executor>::recycle(std::unique_ptr<request_arena> arena) {
+    if (!arena)
+        return;
+    arena->reset();
+    // Keep one spare per response that may be queued, plus the one reading;
+    // beyond that, and arenas a large request grew past the initial size, go
+    // back to the pool, which bounds the bytes it holds per thread
+    if (spare_arenas_.size() <= session_pipeline_limit && arena->capacity() <= request_arena::initial_bytes)
+        spare_arenas_.push_back(std::move(arena));
+    else
+        connection_pool::give_arena(std::move(arena));
+}
+
+template <class Executor>
+void basic_session<Executor>::do_close() {
     beast::error_code ec;
     stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
 }
+
+template class basic_session<shared_session_executor>;
+template class basic_session<core_session_executor>;
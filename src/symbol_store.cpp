@@ -0,0 +1,584 @@
+// symbol_store.cpp
+#include "symbol_store.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include "compute_pool.hpp"
+#include "csv_parser.hpp"
+#include "mapped_file.hpp"
+#include "range_index.hpp"
+#include "return_sketches.hpp"
+#include "series_pyramid.hpp"
+#include "series_snapshot.hpp"
+#include "spdlog/spdlog.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::uint64_t next_lineage() {
+    static std::atomic<std::uint64_t> counter{0};
+    return ++counter;
+}
+
+} // namespace
+
+void symbol_store::set_data_root(const std::string& root) {
+    std::unique_lock lock(mutex_);
+    data_root_ = root;
+    if (!data_root_.empty() && data_root_.back() != '/') {
+        data_root_.push_back('/');
+    }
+}
+
+std::string symbol_store::data_root() const {
+    std::shared_lock lock(mutex_);
+    return data_root_;
+}
+
+void symbol_store::set_snapshot_root(const std::string& root) {
+    std::unique_lock lock(mutex_);
+    snapshot_root_ = root;
+}
+
+void symbol_store::set_verify_snapshots(bool verify) {
+    std::unique_lock lock(mutex_);
+    verify_snapshots_ = verify;
+}
+
+void symbol_store::set_capacity_bytes(std::size_t bytes) {
+    std::lock_guard lock(update_mutex_);
+    capacity_ = bytes;
+    evict_locked(nullptr);
+}
+
+std::size_t symbol_store::resident_bytes(const price_series& series) noexcept {
+    return series.memory_bytes() + (series.index ? series.index->memory_bytes() : 0) +
+           (series.pyramid ? series.pyramid->memory_bytes() : 0) +
+           (series.sketches ? series.sketches->memory_bytes() : 0);
+}
+
+symbol_store::shard& symbol_store::shard_of(std::string_view symbol) const {
+    return shards_[std::hash<std::string_view>{}(symbol) % shard_count];
+}
+
+bool symbol_store::is_valid_symbol(std::string_view symbol) noexcept {
+    if (symbol.empty() || symbol.size() > 64) {
+        return false;
+    }
+    return std::all_of(symbol.begin(), symbol.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '_' || c == '-';
+    });
+}
+
+std::string symbol_store::file_path(std::string_view symbol) const {
+    std::shared_lock lock(mutex_);
+    return data_root_ + std::string(symbol) + ".csv";
+}
+
+std::string symbol_store::snapshot_path(std::string_view symbol) const {
+    std::shared_lock lock(mutex_);
+    return snapshot_file_name(snapshot_root_.empty() ? data_root_ : snapshot_root_, symbol);
+}
+
+std::size_t symbol_store::load_all() {
+    std::vector<std::string> roots;
+    {
+        std::shared_lock lock(mutex_);
+        roots.push_back(data_root_);
+        if (!snapshot_root_.empty() && snapshot_root_ != data_root_) {
+            roots.push_back(snapshot_root_);
+        }
+    }
+
+    // A symbol may have a CSV, a snapshot, or both
+    std::vector<std::string> pending;
+    for (const auto& root : roots) {
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(root, ec)) {
+            const auto ext = entry.path().extension();
+            if (!entry.is_regular_file() || (ext != ".csv" && ext != ".capsnap")) {
+                continue;
+            }
+            std::string symbol = entry.path().stem().string();
+            if (!is_valid_symbol(symbol)) {
+                spdlog::warn("Skipping data file with unsupported name: {}", entry.path().string());
+                continue;
+            }
+            pending.push_back(std::move(symbol));
+        }
+        if (ec) {
+            spdlog::warn("Cannot list {}: {}", root, ec.message());
+        }
+    }
+    std::sort(pending.begin(), pending.end());
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+    {
+        std::unique_lock lock(catalog_mutex_);
+        catalog_.insert(pending.begin(), pending.end());
+    }
+
+    // Files are parsed concurrently, one pool task each. The chunked parse a
+    // large file gets when loaded on its own is a nested parallel_for here,
+    // which runs inline, so each file is parsed by a single thread. Once the
+    // budget is full the rest stay cataloged and load on first use.
+    std::atomic<std::size_t> loaded{0};
+    compute_pool::getInstance().parallel_for(pending.size(), [&](std::size_t i) {
+        const std::size_t capacity = capacity_;
+        if (capacity != 0 && resident_total_ >= capacity) {
+            return;
+        }
+        try {
+            if (get(pending[i])) {
+                ++loaded;
+            }
+        } catch (const std::exception& e) {
+            spdlog::error("Failed to load {}: {}", pending[i], e.what());
+        }
+    });
+    return loaded.load();
+}
+
+std::shared_ptr<const price_series> symbol_store::get(std::string_view symbol) {
+    if (!is_valid_symbol(symbol)) {
+        return nullptr;
+    }
+    std::string key(symbol);
+    {
+        shard& s = shard_of(key);
+        std::lock_guard lock(s.mutex);
+        auto it = s.entries.find(key);
+        if (it != s.entries.end()) {
+            ++s.hits;
+            s.lru.splice(s.lru.begin(), s.lru, it->second.lru);
+            return it->second.series;
+        }
+        ++s.misses;
+    }
+
+    // Load outside the writer lock. Misses that arrive while the symbol is
+    // loading wait for that load instead of parsing the file again; a miss
+    // racing the end of a load may still load a copy, and the first one to
+    // publish wins.
+    auto flight = loads_.run(key, [&] { return load_and_publish(key); });
+    return *flight.value;
+}
+
+bool symbol_store::load_or_wait(std::string_view symbol, std::function<void()> ready) {
+    if (!is_valid_symbol(symbol) || peek(symbol)) {
+        return true;
+    }
+    std::string key(symbol);
+    {
+        shard& s = shard_of(key);
+        std::lock_guard lock(s.mutex);
+        ++s.misses;
+    }
+    try {
+        auto flight = loads_.run(key, [&] { return load_and_publish(key); },
+                                 [ready = std::move(ready)](auto&&) { ready(); });
+        return flight.has_value();
+    } catch (const std::exception&) {
+        // get() tries again and reports it
+        return true;
+    }
+}
+
+std::shared_ptr<const price_series> symbol_store::load_and_publish(const std::string& key) {
+    loaded_series loaded = load(key);
+    if (!loaded.series) {
+        return nullptr;
+    }
+
+    std::lock_guard lock(update_mutex_);
+    if (auto resident = peek(key)) {
+        return resident;
+    }
+    catalog_add(key);
+    csv_extents_[key] = loaded.csv;
+    publish_locked(key, loaded.series);
+
+    // A file event that fired while the file was parsed found the symbol
+    // not resident and only recataloged it; pick up what it missed
+    std::error_code ec;
+    const auto size = loaded.csv.bytes != 0 ? fs::file_size(file_path(key), ec) : 0;
+    if (!ec && size > loaded.csv.bytes) {
+        refresh_locked(key, true);
+        if (auto current = peek(key)) {
+            return current;
+        }
+    }
+    return loaded.series;
+}
+
+std::shared_ptr<const price_series> symbol_store::peek(std::string_view symbol) const {
+    std::string key(symbol);
+    shard& s = shard_of(key);
+    std::lock_guard lock(s.mutex);
+    auto it = s.entries.find(key);
+    return it == s.entries.end() ? nullptr : it->second.series;
+}
+
+void symbol_store::refresh(std::string_view symbol, bool complete_lines_only) {
+    if (!is_valid_symbol(symbol)) {
+        return;
+    }
+    std::lock_guard lock(update_mutex_);
+    refresh_locked(std::string(symbol), complete_lines_only);
+}
+
+void symbol_store::refresh_locked(const std::string& key, bool complete_lines_only) {
+    std::string path = file_path(key);
+    std::error_code ec;
+    auto current = peek(key);
+    if (!current) {
+        // Not resident: the next get() reads the whole file anyway
+        recatalog(key);
+        return;
+    }
+    auto extent = csv_extents_.find(key);
+    // Loaded from a snapshot with no CSV behind it, or the CSV is gone
+    if (extent == csv_extents_.end() || extent->second.bytes == 0 || !fs::is_regular_file(path, ec)) {
+        reload_locked(key);
+        return;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        mapped_file file(path);
+        const std::size_t offset = extent->second.bytes;
+        if (file.size() < offset) {
+            spdlog::info("{} shrank from {} to {} bytes; reloading", path, offset, file.size());
+            reload_locked(key);
+            return;
+        }
+        // A row added at the top of a newest-first export, or a newer export
+        // copied over the file, changes what lies before the offset; what
+        // follows it is then not an append
+        if (csv_fingerprint(file.view(), offset) != extent->second.fingerprint) {
+            spdlog::info("{} changed before byte {}; reloading", path, offset);
+            reload_locked(key);
+            return;
+        }
+
+        if (extent->second.lines < offset) {
+            // The last line was parsed without its newline, as the shipped
+            // exports end. Whatever follows may continue that line instead
+            // of starting a row, so read the file as a whole again
+            std::string_view continued = file.view().substr(offset);
+            if (continued.empty() || (complete_lines_only && continued.find('\n') == std::string_view::npos)) {
+                return;
+            }
+            spdlog::info("{} grew past its unterminated last line; reloading", path);
+            reload_locked(key);
+            return;
+        }
+
+        std::string_view added = file.view().substr(offset);
+        if (complete_lines_only) {
+            std::size_t end = added.rfind('\n');
+            added = added.substr(0, end == std::string_view::npos ? 0 : end + 1);
+        }
+        if (added.empty()) {
+            return;
+        }
+
+        // Copy the published version and extend the copy; readers keep
+        // using the old one until the swap below
+        csv_reader head(file.view());
+        auto next = std::make_shared<price_series>(*current);
+        std::size_t rows = append_price_rows(*next, head.header(), added, path);
+        extent->second = csv_extent_of(file.view(), offset + added.size());
+        if (rows == 0) {
+            return; // blank lines only
+        }
+        // Rows may have been sorted in before the old tail; the pyramid and
+        // the sketches keep what lies before the first row that moved
+        const price_series& prev = *current;
+        std::size_t first_changed = static_cast<std::size_t>(
+            std::mismatch(prev.day.begin(), prev.day.end(), next->day.begin()).first - prev.day.begin());
+        next->lineage = first_changed == prev.size() ? prev.lineage : next_lineage();
+        next->index = std::make_shared<const range_index>(*next);
+        next->pyramid = prev.pyramid
+            ? std::make_shared<const series_pyramid>(*next, *prev.pyramid, first_changed)
+            : std::make_shared<const series_pyramid>(*next);
+        next->sketches = prev.sketches
+            ? std::make_shared<const return_sketches>(*next, *prev.sketches, first_changed)
+            : std::make_shared<const return_sketches>(*next);
+        publish_locked(key, std::move(next));
+
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        spdlog::info("Appended {} rows ({} bytes) to {} in {:.2f} ms", rows, added.size(), key, elapsed.count());
+    } catch (const std::exception& e) {
+        // The appended bytes did not parse against the rows before them
+        spdlog::warn("Failed to append to {} ({}); reloading", path, e.what());
+        reload_locked(key);
+    }
+}
+
+void symbol_store::reload(std::string_view symbol) {
+    if (!is_valid_symbol(symbol)) {
+        return;
+    }
+    std::lock_guard lock(update_mutex_);
+    std::string key(symbol);
+    if (!peek(key)) {
+        recatalog(key);
+        return;
+    }
+    reload_locked(key);
+}
+
+void symbol_store::refresh_all() {
+    std::vector<std::string> names = symbols();
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(data_root(), ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".csv") {
+            names.push_back(entry.path().stem().string());
+        }
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    for (const auto& name : names) {
+        refresh(name, true);
+    }
+}
+
+void symbol_store::reload_locked(const std::string& symbol) {
+    try {
+        loaded_series loaded = load(symbol);
+        if (!loaded.series) {
+            if (peek(symbol)) {
+                spdlog::info("Data files for {} are gone; dropping it", symbol);
+            }
+            catalog_remove(symbol);
+            csv_extents_.erase(symbol);
+            publish_locked(symbol, nullptr);
+            return;
+        }
+        catalog_add(symbol);
+        csv_extents_[symbol] = loaded.csv;
+        publish_locked(symbol, std::move(loaded.series));
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to reload {}: {}", symbol, e.what());
+    }
+}
+
+void symbol_store::publish_locked(const std::string& symbol, std::shared_ptr<const price_series> series) {
+    const bool needs_index = series && !series->index;
+    const std::size_t bytes = series ? resident_bytes(*series) : 0;
+    {
+        shard& s = shard_of(symbol);
+        std::lock_guard lock(s.mutex);
+        auto it = s.entries.find(symbol);
+        if (!series) {
+            if (it == s.entries.end()) {
+                return;
+            }
+            s.bytes -= it->second.bytes;
+            resident_total_ -= it->second.bytes;
+            s.lru.erase(it->second.lru);
+            s.entries.erase(it);
+            return;
+        }
+        if (it == s.entries.end()) {
+            s.lru.push_front(symbol);
+            it = s.entries.emplace(symbol, cache_entry{nullptr, 0, s.lru.begin()}).first;
+        } else {
+            s.lru.splice(s.lru.begin(), s.lru, it->second.lru);
+        }
+        s.bytes = s.bytes - it->second.bytes + bytes;
+        resident_total_ += bytes;
+        resident_total_ -= it->second.bytes;
+        it->second.series = series;
+        it->second.bytes = bytes;
+    }
+    evict_locked(&symbol);
+
+    if (needs_index) {
+        index_in_background(symbol, std::move(series));
+    }
+}
+
+void symbol_store::evict_locked(const std::string* keep) {
+    const std::size_t capacity = capacity_;
+    if (capacity == 0) {
+        return;
+    }
+    // The budget is global, so series of one shard do not evict each other
+    // while the others have room. Shards give up their coldest series in
+    // turn, which spreads evictions evenly without a store-wide LRU list.
+    std::size_t idle = 0;
+    while (resident_total_ > capacity && idle < shard_count) {
+        shard& s = shards_[evict_cursor_];
+        evict_cursor_ = (evict_cursor_ + 1) % shard_count;
+        std::lock_guard lock(s.mutex);
+        idle = evict_one_locked(s, keep) ? 0 : idle + 1;
+    }
+}
+
+bool symbol_store::evict_one_locked(shard& s, const std::string* keep) {
+    for (auto it = s.lru.end(); it != s.lru.begin();) {
+        --it;
+        if (keep && *it == *keep) {
+            continue;
+        }
+        auto entry = s.entries.find(*it);
+        s.bytes -= entry->second.bytes;
+        resident_total_ -= entry->second.bytes;
+        ++s.evictions;
+        csv_extents_.erase(*it);
+        spdlog::debug("Evicted {} ({} bytes) from the symbol cache", *it, entry->second.bytes);
+        s.entries.erase(entry);
+        s.lru.erase(it);
+        return true;
+    }
+    return false;
+}
+
+void symbol_store::index_in_background(const std::string& symbol, std::shared_ptr<const price_series> series) {
+    // Mapped snapshots are published before their range index and pyramid
+    // exist, so that startup does not scan the columns; queries fall back to
+    // scanning the daily rows until the indexed version replaces this one
+    compute_pool::getInstance().post([this, symbol, series = std::move(series)] {
+        auto index = std::make_shared<const range_index>(*series);
+        auto pyramid = std::make_shared<const series_pyramid>(*series);
+        auto sketches = std::make_shared<const return_sketches>(*series);
+        std::lock_guard lock(update_mutex_);
+        if (peek(symbol) != series) {
+            return; // superseded or evicted meanwhile
+        }
+        auto next = std::make_shared<price_series>(*series);
+        next->index = std::move(index);
+        next->pyramid = std::move(pyramid);
+        next->sketches = std::move(sketches);
+        publish_locked(symbol, std::move(next));
+    });
+}
+
+symbol_store::loaded_series symbol_store::load(std::string_view symbol) const {
+    std::string path = file_path(symbol);
+    std::string snap_path = snapshot_path(symbol);
+    std::error_code ec;
+    const bool has_csv = fs::is_regular_file(path, ec);
+    const bool has_snapshot = fs::is_regular_file(snap_path, ec);
+    bool verify;
+    {
+        std::shared_lock lock(mutex_);
+        verify = verify_snapshots_;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed_ms = [&start] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    loaded_series loaded;
+    if (has_snapshot) {
+        try {
+            series_snapshot snapshot = open_series_snapshot(snap_path, verify);
+            if (!has_csv || snapshot_matches_source(snapshot.info, path)) {
+                snapshot.series.symbol = std::string(symbol);
+                spdlog::info("Mapped {} ({} rows) in {:.2f} ms", snap_path, snapshot.series.size(), elapsed_ms());
+                snapshot.series.lineage = next_lineage();
+                loaded.series = std::make_shared<const price_series>(std::move(snapshot.series));
+                if (has_csv) {
+                    // Same size and mtime as the CSV it was written from
+                    mapped_file csv(path);
+                    loaded.csv = csv_extent_of(csv.view(), static_cast<std::size_t>(snapshot.info.source_size));
+                }
+                return loaded;
+            }
+            spdlog::warn("Snapshot {} does not match the size or mtime of {}; parsing the CSV", snap_path, path);
+        } catch (const std::exception& e) {
+            if (!has_csv) {
+                throw;
+            }
+            spdlog::warn("{}; parsing {} instead", e.what(), path);
+        }
+    }
+    if (!has_csv) {
+        return loaded;
+    }
+
+    auto series = std::make_shared<price_series>(load_price_series(std::string(symbol), path, &loaded.csv));
+    series->lineage = next_lineage();
+    series->index = std::make_shared<const range_index>(*series);
+    series->pyramid = std::make_shared<const series_pyramid>(*series);
+    series->sketches = std::make_shared<const return_sketches>(*series);
+    loaded.series = std::move(series);
+    spdlog::info("Loaded {} ({} rows) in {:.2f} ms", path, loaded.series->size(), elapsed_ms());
+    return loaded;
+}
+
+std::vector<std::string> symbol_store::symbols() const {
+    std::vector<std::string> names;
+    for (const shard& s : shards_) {
+        std::lock_guard lock(s.mutex);
+        for (const auto& [name, entry] : s.entries) {
+            names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::vector<std::string> symbol_store::catalog(std::string_view prefix, std::string_view after,
+                                               std::size_t limit, std::size_t* total) const {
+    std::shared_lock lock(catalog_mutex_);
+    auto first = catalog_.lower_bound(std::string(prefix));
+    auto matches = [&](const std::string& name) { return name.compare(0, prefix.size(), prefix) == 0; };
+    std::vector<std::string> names;
+    std::size_t count = 0;
+    for (auto it = first; it != catalog_.end() && matches(*it); ++it) {
+        ++count;
+        if (*it > after && names.size() < limit) {
+            names.push_back(*it);
+        } else if (!total && names.size() == limit) {
+            break;
+        }
+    }
+    if (total) {
+        *total = count;
+    }
+    return names;
+}
+
+symbol_cache_stats symbol_store::cache_stats() const {
+    symbol_cache_stats stats;
+    stats.capacity = capacity_;
+    for (const shard& s : shards_) {
+        std::lock_guard lock(s.mutex);
+        stats.hits += s.hits;
+        stats.misses += s.misses;
+        stats.evictions += s.evictions;
+        stats.resident += s.entries.size();
+        stats.bytes += s.bytes;
+    }
+    single_flight_stats flights = loads_.stats();
+    stats.loads = flights.executed;
+    stats.coalesced_loads = flights.coalesced;
+    return stats;
+}
+
+void symbol_store::catalog_add(const std::string& symbol) {
+    std::unique_lock lock(catalog_mutex_);
+    catalog_.insert(symbol);
+}
+
+void symbol_store::catalog_remove(const std::string& symbol) {
+    std::unique_lock lock(catalog_mutex_);
+    catalog_.erase(symbol);
+}
+
+void symbol_store::recatalog(const std::string& symbol) {
+    std::error_code ec;
+    if (fs::is_regular_file(file_path(symbol), ec) || fs::is_regular_file(snapshot_path(symbol), ec)) {
+        catalog_add(symbol);
+    } else {
+        catalog_remove(symbol);
+    }
+}
@@ -0,0 +1,145 @@
+// tdigest.cpp
+#include "tdigest.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr double pi = 3.141592653589793;
+
+// Values buffered per centroid of compression before compress() runs on its own
+constexpr double buffer_factor = 8.0;
+
+// Arcsine scale function k1 and its inverse: one unit of k is the widest a
+// centroid may be, which is narrow at the tails and wide at the median
+double scale_k(double q, double compression) {
+    return compression / (2.0 * pi) * std::asin(2.0 * q - 1.0);
+}
+
+double scale_q(double k, double compression) {
+    if (k >= compression / 4.0) {
+        return 1.0;
+    }
+    return (std::sin(k * 2.0 * pi / compression) + 1.0) / 2.0;
+}
+
+} // namespace
+
+tdigest::tdigest(double compression)
+    : compression_(compression),
+      min_(std::numeric_limits<double>::infinity()),
+      max_(-std::numeric_limits<double>::infinity())
+{
+}
+
+void tdigest::add(double x, double weight) {
+    buffer_.push_back({x, weight});
+    total_ += weight;
+    min_ = std::min(min_, x);
+    max_ = std::max(max_, x);
+    if (static_cast<double>(buffer_.size()) >= buffer_factor * compression_) {
+        compress();
+    }
+}
+
+void tdigest::merge(const tdigest& other) {
+    if (other.total_ == 0.0) {
+        return;
+    }
+    buffer_.insert(buffer_.end(), other.centroids_.begin(), other.centroids_.end());
+    buffer_.insert(buffer_.end(), other.buffer_.begin(), other.buffer_.end());
+    total_ += other.total_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    if (static_cast<double>(buffer_.size()) >= buffer_factor * compression_) {
+        compress();
+    }
+}
+
+void tdigest::compress() {
+    if (buffer_.empty()) {
+        return;
+    }
+    buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+    std::sort(buffer_.begin(), buffer_.end(),
+              [](const centroid& a, const centroid& b) { return a.mean < b.mean; });
+    centroids_.clear();
+
+    // One pass from the left: grow the current centroid while the quantile
+    // it would end at stays within one unit of k from where it started
+    double so_far = 0.0;
+    double limit = scale_q(scale_k(0.0, compression_) + 1.0, compression_);
+    centroid current = buffer_.front();
+    for (std::size_t i = 1; i < buffer_.size(); ++i) {
+        const centroid& next = buffer_[i];
+        if ((so_far + current.weight + next.weight) / total_ <= limit) {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        } else {
+            centroids_.push_back(current);
+            so_far += current.weight;
+            limit = scale_q(scale_k(so_far / total_, compression_) + 1.0, compression_);
+            current = next;
+        }
+    }
+    centroids_.push_back(current);
+    buffer_.clear();
+}
+
+void tdigest::shrink_to_fit() {
+    compress();
+    centroids_.shrink_to_fit();
+    buffer_ = std::vector<centroid>();
+}
+
+double tdigest::quantile(double q) const {
+    if (centroids_.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (centroids_.size() == 1) {
+        return centroids_.front().mean;
+    }
+
+    // Each centroid sits at the rank of its centre; between centres, and
+    // from the outer centres to min and max, the value is interpolated
+    const double rank = std::clamp(q, 0.0, 1.0) * total_;
+    const centroid& first = centroids_.front();
+    if (rank < first.weight / 2.0) {
+        if (first.weight == 1.0) {
+            return first.mean;
+        }
+        return min_ + (first.mean - min_) * rank / (first.weight / 2.0);
+    }
+    double so_far = 0.0;
+    for (std::size_t i = 0; i + 1 < centroids_.size(); ++i) {
+        const centroid& a = centroids_[i];
+        const centroid& b = centroids_[i + 1];
+        const double left = so_far + a.weight / 2.0;
+        const double right = so_far + a.weight + b.weight / 2.0;
+        if (rank < right) {
+            return a.mean + (b.mean - a.mean) * (rank - left) / (right - left);
+        }
+        so_far += a.weight;
+    }
+    const centroid& last = centroids_.back();
+    const double centre = total_ - last.weight / 2.0;
+    if (last.weight == 1.0 || rank <= centre) {
+        return last.mean;
+    }
+    return last.mean + (max_ - last.mean) * (rank - centre) / (last.weight / 2.0);
+}
+
+double tdigest::rank_error(double q) const noexcept {
+    if (exact()) {
+        return 0.0;
+    }
+    // dq/dk of k1 is 2 pi sqrt(q (1 - q)) / compression; a centroid spans
+    // at most one unit of k and quantile() is off by at most half of it
+    q = std::clamp(q, 0.0, 1.0);
+    return std::max(pi * std::sqrt(q * (1.0 - q)) / compression_, 0.5 / total_);
+}
+
+std::size_t tdigest::memory_bytes() const noexcept {
+    return (centroids_.capacity() + buffer_.capacity()) * sizeof(centroid);
+}
@@ -0,0 +1,116 @@
+// cap_keepalive.cpp
+// Regression check for long-lived keep-alive connections against a running
+// server. Sends GET /hello every ping interval for idle seconds, longer than
+// the server's 30 s stream timeout, then downloads target on the same
+// connection through a small receive window (optionally pausing between
+// reads), so that the response cannot be written in one go. Use a target of
+// a few MB or more. Fails unless the whole body arrives.
+//
+//   cap_keepalive <host> <port> <target> [idle_seconds] [ping_seconds] [read_delay_ms]
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+namespace {
+
+using tool_clock = std::chrono::steady_clock;
+
+double elapsed_s(tool_clock::time_point start) {
+    return std::chrono::duration<double>(tool_clock::now() - start).count();
+}
+
+http::request<http::empty_body> make_get(const std::string& host, const std::string& target) {
+    http::request<http::empty_body> req{http::verb::get, target, 11};
+    req.set(http::field::host, host);
+    req.set(http::field::user_agent, "cap-keepalive/1.0");
+    req.keep_alive(true);
+    return req;
+}
+
+int check(const std::string& host, const std::string& port, const std::string& target,
+          int idle_seconds, int ping_seconds, int read_delay_ms) {
+    net::io_context ioc;
+    tcp::socket socket(ioc);
+    net::connect(socket, tcp::resolver(ioc).resolve(host, port));
+    // A small receive window keeps the server's write waiting on the reader
+    socket.set_option(net::socket_base::receive_buffer_size(16 * 1024));
+    const auto start = tool_clock::now();
+
+    beast::flat_buffer buffer;
+    int pings = 0;
+    while (elapsed_s(start) < idle_seconds) {
+        http::write(socket, make_get(host, "/hello"));
+        http::response<http::string_body> res;
+        http::read(socket, buffer, res);
+        if (res.result() != http::status::ok || !res.keep_alive()) {
+            std::cerr << "ping " << pings << " at " << elapsed_s(start) << " s: " << res.result_int() << "\n";
+            return EXIT_FAILURE;
+        }
+        ++pings;
+        std::this_thread::sleep_for(std::chrono::seconds(ping_seconds));
+    }
+
+    http::write(socket, make_get(host, target));
+    http::response_parser<http::buffer_body> parser;
+    parser.body_limit(std::numeric_limits<std::uint64_t>::max());
+    http::read_header(socket, buffer, parser);
+    const auto expected = parser.content_length();
+
+    std::size_t received = 0;
+    char chunk[16 * 1024];
+    beast::error_code ec;
+    while (!parser.is_done()) {
+        parser.get().body().data = chunk;
+        parser.get().body().size = sizeof(chunk);
+        http::read_some(socket, buffer, parser, ec);
+        if (ec == http::error::need_buffer) {
+            ec = {};
+        }
+        received += sizeof(chunk) - parser.get().body().size;
+        if (ec) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(read_delay_ms));
+    }
+
+    std::cout << target << " after " << pings << " pings over " << idle_seconds << " s: "
+              << received << " of " << (expected ? std::to_string(*expected) : std::string("?"))
+              << " bytes in " << elapsed_s(start) << " s";
+    if (ec || !parser.is_done() || (expected && received != *expected)) {
+        std::cout << (ec ? " (" + ec.message() + ")" : std::string()) << " FAILED\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << " ok\n";
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "usage: cap_keepalive <host> <port> <target> [idle_seconds] [ping_seconds] [read_delay_ms]\n";
+        return EXIT_FAILURE;
+    }
+    int idle_seconds = argc > 4 ? std::atoi(argv[4]) : 40;
+    int ping_seconds = argc > 5 ? std::atoi(argv[5]) : 10;
+    int read_delay_ms = argc > 6 ? std::atoi(argv[6]) : 0;
+    try {
+        return check(argv[1], argv[2], argv[3], idle_seconds, ping_seconds, read_delay_ms);
+    } catch (const std::exception& e) {
+        std::cerr << "cap_keepalive: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
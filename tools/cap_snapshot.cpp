@@ -0,0 +1,138 @@
+// cap_snapshot.cpp
+// Converts price CSVs into the binary snapshots the server maps at startup.
+//
+//   cap_snapshot build <file.csv> [out.capsnap]
+//   cap_snapshot build-all <data_dir> [out_dir]
+//   cap_snapshot verify <file.capsnap> [file.csv]
+//   cap_snapshot info <file.capsnap>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include "spdlog/spdlog.h"
+#include "price_series.hpp"
+#include "series_snapshot.hpp"
+#include "symbol_store.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using tool_clock = std::chrono::steady_clock;
+
+double elapsed_ms(tool_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(tool_clock::now() - start).count();
+}
+
+void build(const std::string& csv_path, const std::string& out_path) {
+    auto start = tool_clock::now();
+    const std::string symbol = fs::path(csv_path).stem().string();
+    price_series series = load_price_series(symbol, csv_path);
+    write_series_snapshot(series, out_path, csv_path);
+    std::cout << out_path << ": " << series.size() << " rows in " << elapsed_ms(start) << " ms\n";
+}
+
+int build_all(const std::string& data_dir, const std::string& out_dir) {
+    int failures = 0;
+    for (const auto& entry : fs::directory_iterator(data_dir)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".csv") {
+            continue;
+        }
+        const std::string symbol = entry.path().stem().string();
+        if (!symbol_store::is_valid_symbol(symbol)) {
+            std::cerr << "skipping " << entry.path().string() << ": unsupported name\n";
+            continue;
+        }
+        try {
+            build(entry.path().string(), snapshot_file_name(out_dir, symbol));
+        } catch (const std::exception& e) {
+            std::cerr << entry.path().string() << ": " << e.what() << "\n";
+            ++failures;
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void print_info(const snapshot_info& info) {
+    std::cout << "symbol:       " << info.symbol << "\n"
+              << "version:      " << info.version << "\n"
+              << "rows:         " << info.rows << "\n"
+              << "file size:    " << info.file_size << "\n"
+              << "source size:  " << info.source_size << "\n"
+              << "source mtime: " << info.source_mtime_ns << " ns\n"
+              << "checksum:     " << std::hex << info.checksum << std::dec << "\n";
+}
+
+// Checks the checksum and, given the source CSV, that every value matches a
+// fresh parse of it
+int verify(const std::string& snap_path, const std::string& csv_path) {
+    series_snapshot snapshot = open_series_snapshot(snap_path, true);
+    std::cout << snap_path << ": checksum ok, " << snapshot.info.rows << " rows\n";
+    if (csv_path.empty()) {
+        return EXIT_SUCCESS;
+    }
+
+    price_series parsed = load_price_series(snapshot.info.symbol, csv_path);
+    const price_series& mapped = snapshot.series;
+    bool same = parsed.size() == mapped.size();
+    for (std::size_t i = 0; same && i < parsed.size(); ++i) {
+        auto same_value = [](double a, double b) { return a == b || (a != a && b != b); };
+        same = parsed.day[i] == mapped.day[i] && same_value(parsed.price[i], mapped.price[i]) &&
+               same_value(parsed.open[i], mapped.open[i]) && same_value(parsed.high[i], mapped.high[i]) &&
+               same_value(parsed.low[i], mapped.low[i]) && same_value(parsed.volume[i], mapped.volume[i]) &&
+               same_value(parsed.change_percent[i], mapped.change_percent[i]);
+    }
+    if (!same) {
+        std::cerr << snap_path << ": values differ from " << csv_path << "\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << snap_path << ": matches " << csv_path
+              << (snapshot_matches_source(snapshot.info, csv_path) ? "" : " (but the CSV size or mtime changed)")
+              << "\n";
+    return EXIT_SUCCESS;
+}
+
+void usage() {
+    std::cerr << "usage: cap_snapshot build <file.csv> [out.capsnap]\n"
+                 "       cap_snapshot build-all <data_dir> [out_dir]\n"
+                 "       cap_snapshot verify <file.capsnap> [file.csv]\n"
+                 "       cap_snapshot info <file.capsnap>\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    spdlog::set_level(spdlog::level::warn);
+
+    if (argc < 3) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string mode = argv[1];
+    const std::string path = argv[2];
+    try {
+        if (mode == "build") {
+            fs::path csv(path);
+            build(path, argc > 3 ? argv[3] : snapshot_file_name(csv.parent_path().string(), csv.stem().string()));
+            return EXIT_SUCCESS;
+        }
+        if (mode == "build-all") {
+            return build_all(path, argc > 3 ? argv[3] : path);
+        }
+        if (mode == "verify") {
+            return verify(path, argc > 3 ? argv[3] : "");
+        }
+        if (mode == "info") {
+            print_info(open_series_snapshot(path).info);
+            return EXIT_SUCCESS;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "cap_snapshot: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    usage();
+    return EXIT_FAILURE;
+}